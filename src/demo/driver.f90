@@ -74,6 +74,8 @@ program driver
   integer, target                   :: i = 0
   integer                           :: id
   integer, pointer                  :: pint
+  integer( c_int32_t ), dimension( 2, 64 ) :: events
+  integer( c_size_t )               :: numEvents
 #include "built_in_path.inc"
 
   arr(:) = 0
@@ -87,8 +89,14 @@ program driver
   call EmbeddedInterpreter_initialize( interpreter )
   call EmbeddedInterpreter_addToScope( interpreter,  f_c_string( BUILT_IN_PATH ) )
 
+  ! Embedded modules are created at runtime, attributes are only defined once python uses them
   call EmbeddedInterpreter_embeddedPymoduleLoad( interpreter, f_c_string( "runtime_data" ) )
   call EmbeddedInterpreter_embeddedPymoduleLoad( interpreter, f_c_string( "static_data"  ) )
+  call EmbeddedInterpreter_embeddedPymoduleLoad( interpreter, f_c_string( "helper"       ) )
+  call EmbeddedInterpreter_embeddedPymoduleLoad( interpreter, f_c_string( "demo"         ) )
+#ifdef SOME_FEATURE
+  call EmbeddedInterpreter_embeddedPymoduleLoad( interpreter, f_c_string( "feature_mod"  ) )
+#endif
   
   
   ! Add embedded values
@@ -104,6 +112,11 @@ program driver
                                                 f_c_string( "getDemo3" ), f_c_string( "demo3" ), &
                                                 c_funloc( getRegularFloatValue ) )
 
+  ! Constant for the run, only ask Fortran once - getDemo3 may change, ask once per step
+  call EmbeddedInterpreter_valueCache( interpreter, f_c_string( "static_data" ), f_c_string( "getDemo1" ), EI_CACHE_ONCE  )
+  call EmbeddedInterpreter_valueCache( interpreter, f_c_string( "static_data" ), f_c_string( "getDemo2" ), EI_CACHE_ONCE  )
+  call EmbeddedInterpreter_valueCache( interpreter, f_c_string( "static_data" ), f_c_string( "getDemo3" ), EI_CACHE_EPOCH )
+
 
   call EmbeddedInterpreter_embedInt32ValueCase( interpreter, f_c_string( "runtime_data" ), &
                                                 f_c_string( "omp_enabled" ), f_c_string( "omp" ), &
@@ -118,13 +131,34 @@ program driver
   call EmbeddedInterpreter_embedInt32PtrScalar( interpreter, f_c_string( "runtime_data" ), &
                                                 f_c_string( "numDims"), id )
 
+  ! Records of ( thread, value ) python sends back via runtime_data.emit( "events", ... )
+  call EmbeddedInterpreter_channelCreateInt32( interpreter, f_c_string( "runtime_data" ), f_c_string( "events" ), &
+                                               2_c_size_t, 64_c_size_t )
+
 
   ! Use user module
   call EmbeddedInterpreter_pymoduleLoad( interpreter,  f_c_string( "interp.euler" ) )
 
+  ! Account python allocation per call, warn about any call peaking over 64 MiB
+  call EmbeddedInterpreter_memoryTracking( interpreter, .true._c_bool )
+  call EmbeddedInterpreter_memoryBudget  ( interpreter, f_c_string( "" ), f_c_string( "" ), &
+                                           64_c_size_t * 1024 * 1024, EI_BUDGET_LOG )
+
+  ! Sample python stacks of calls at a low rate, written to pyio_profile.<rank>.folded
+  call EmbeddedInterpreter_profilerStart( interpreter, 50.0_c_double, f_c_string( "pyio_profile" ) )
+
+  ! Record embedded data and calls for offline replay with pyio_replay pyio_trace.bin
+  call EmbeddedInterpreter_recordStart( interpreter, f_c_string( "pyio_trace.bin" ), 0_c_size_t )
+
   ! Typical steps to be done - init, then call as needed, fin
   call EmbeddedInterpreter_pymoduleCall( interpreter,  f_c_string( "interp.euler" ), f_c_string( "initialize" ) )
 
+  ! Let python know arr has changed since initialize, new step for cached values
+  call EmbeddedInterpreter_advanceEpoch( interpreter )
+  arr(1) = 1
+  call EmbeddedInterpreter_markDirtyRange( interpreter, f_c_string( "runtime_data" ), f_c_string( "arr" ), &
+                                           1_c_size_t, 1_c_size_t )
+
   call EmbeddedInterpreter_threadingInit( interpreter )
   ! Do some parallel processing
   !$OMP PARALLEL DO
@@ -141,10 +175,21 @@ program driver
   end do
   !$OMP END PARALLEL DO
   call EmbeddedInterpreter_threadingFinalize( interpreter )
+
+  ! Collect what every thread emitted
+  call EmbeddedInterpreter_channelDrainInt32( interpreter, f_c_string( "runtime_data" ), f_c_string( "events" ), &
+                                              events, size( events, 2, c_size_t ), numEvents )
+  do i = 1, int( numEvents )
+    write( *, * ) "[Fortran] event : ", events( :, i )
+  end do
   call sleep(5)
 
   call EmbeddedInterpreter_pymoduleCall( interpreter,  f_c_string( "interp.euler" ), f_c_string( "finalize" ) )
 
+  ! Dump runtime arrays natively, readable with numpy.load( mmap_mode='r' )
+  call EmbeddedInterpreter_arrayDumpModule( interpreter, f_c_string( "runtime_data" ), f_c_string( "." ), &
+                                            EI_DUMP_ASYNC_SNAPSHOT )
+
   ! finalize
   call EmbeddedInterpreter_finalize( interpreter )
 
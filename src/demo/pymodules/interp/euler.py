@@ -11,6 +11,7 @@ def initialize( ) :
   print( logstr.format( file=filename, func=initialize.__name__ ) )
 
   print( "pint = {0}".format( runtime_data.pint() ) )
+  print( "arr version = {0}".format( runtime_data.version( "arr" ) ) )
 
 def finalize( ) :
   print( logstr.format( file=filename, func=finalize.__name__ ) )
@@ -26,6 +27,19 @@ def main( ) :
   print( type( arr ) )
   print( arr.flags )
 
+  # Only recomputed when Fortran marks arr dirty
+  print( "arr sum = {0}, dirty = {1}".format( runtime_data.memoize( "arr", numpy.sum ), runtime_data.dirty( "arr" ) ) )
+
+  # Bandwidth friendly copies for analysis that tolerates lower precision
+  arr16 = runtime_data.reduced( "arr", "float16" )
+  arr8, offset, scale = runtime_data.reduced( "arr", "uint8" )
+  print( "arr float16 max = {0}, uint8 max = {1}".format( arr16.max(), offset + arr8.max() * scale ) )
+
+  # Parallel native reductions, only the results cross into python
+  stats = runtime_data.stats( "arr" )
+  counts, edges, nan = runtime_data.histogram( "arr", bins=4 )
+  print( "arr min = {0}, max = {1}, mean = {2}, nan = {3}, histogram = {4}".format( stats["min"], stats["max"], stats["mean"], nan, counts ) )
+
   arr[5] = 999
   arr[2] = static_data.getDemo1()
   arr[1] = static_data.getDemo2()
@@ -35,3 +49,6 @@ def main( ) :
   if id < arr.size :
     print( "Writing from thread {}".format( id ) )
 
+  # Variable length results go back natively, drained by Fortran after the parallel region
+  runtime_data.emit( "events", ( id, int( numpy.count_nonzero( arr ) ) ) )
+
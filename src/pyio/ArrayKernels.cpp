@@ -0,0 +1,482 @@
+#include "ArrayKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#define PARALLEL_FOR_SIMD _Pragma( "omp parallel for simd" )
+#else
+#define PARALLEL_FOR_SIMD
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Report an array type the kernels do not handle
+////////////////////////////////////////////////////////////////////////////////
+static void
+unsupported(
+            const EmbeddedArray &array, ///< array that could not be handled
+            const char          *func   ///< calling function
+            )
+{
+  std::stringstream ss;
+  ss << __FILE__ << ":" << __LINE__ << " : Error: " << func << " does not support array type '" << array.descr() << "'" << std::endl;
+  std::cerr << ss.str();
+  throw std::runtime_error( ss.str() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Classify on the bit pattern, std::isfinite / std::isnan and even
+///        equality based tests may be vectorized into signaling compares that
+///        raise FE_INVALID for NaN on worker threads outside the FPE guard
+///
+/// Only the upper 32 bits are needed for finiteness, which keeps the integer
+/// compares to widths SSE2 can vectorize
+////////////////////////////////////////////////////////////////////////////////
+static inline bool
+isFinite( double value )
+{
+  uint64_t bits;
+  std::memcpy( &bits, &value, sizeof( bits ) );
+  return ( static_cast< uint32_t >( bits >> 32 ) & 0x7ff00000u ) != 0x7ff00000u;
+}
+
+static inline bool
+isNaN( double value )
+{
+  uint64_t bits;
+  std::memcpy( &bits, &value, sizeof( bits ) );
+  return ( bits & 0x7fffffffffffffffULL ) > 0x7ff0000000000000ULL;
+}
+
+static inline bool
+isPositiveInf( double value )
+{
+  uint64_t bits;
+  std::memcpy( &bits, &value, sizeof( bits ) );
+  return bits == 0x7ff0000000000000ULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Min and max of all finite values
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void
+finiteMinMaxTyped( const T *src, long long n, double &min, double &max, size_t &numFinite )
+{
+  double    lo    =  std::numeric_limits< double >::infinity();
+  double    hi    = -std::numeric_limits< double >::infinity();
+  long long count = 0;
+
+#ifdef _OPENMP
+  #pragma omp parallel for reduction( min : lo ) reduction( max : hi ) reduction( + : count )
+#endif
+  for ( long long i = 0; i < n; i++ )
+  {
+    double value = static_cast< double >( src[i] );
+    if ( isFinite( value ) )
+    {
+      lo = value < lo ? value : lo;
+      hi = value > hi ? value : hi;
+      count++;
+    }
+  }
+
+  min       = lo;
+  max       = hi;
+  numFinite = static_cast< size_t >( count );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Counts, extrema, and sum of finite values in one pass, then the
+///        variance about the mean in a second pass to avoid cancellation
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void
+statsTyped( const T *src, long long n, ArrayKernels::Stats &stats )
+{
+  double    lo     =  std::numeric_limits< double >::infinity();
+  double    hi     = -std::numeric_limits< double >::infinity();
+  double    sum    = 0.0;
+  long long count  = 0;
+  long long numNaN = 0;
+
+#ifdef _OPENMP
+  #pragma omp parallel for simd reduction( min : lo ) reduction( max : hi ) reduction( + : sum, count, numNaN )
+#endif
+  for ( long long i = 0; i < n; i++ )
+  {
+    // Non-finite values are swapped out before any ordered comparison, the loop
+    // is vectorized so both sides of a condition are evaluated
+    double value  = static_cast< double >( src[i] );
+    bool   finite = isFinite( value );
+    double low    = finite ? value :  std::numeric_limits< double >::infinity();
+    double high   = finite ? value : -std::numeric_limits< double >::infinity();
+    lo      = low  < lo ? low  : lo;
+    hi      = high > hi ? high : hi;
+    sum    += finite ? value : 0.0;
+    count  += finite ? 1 : 0;
+    numNaN += isNaN( value ) ? 1 : 0;
+  }
+
+  const double nan = std::numeric_limits< double >::quiet_NaN();
+  double       mean = count > 0 ? sum / count : nan;
+  double       sqr  = 0.0;
+
+#ifdef _OPENMP
+  #pragma omp parallel for simd reduction( + : sqr )
+#endif
+  for ( long long i = 0; i < n; i++ )
+  {
+    double value = static_cast< double >( src[i] );
+    double delta = ( isFinite( value ) ? value : mean ) - mean;
+    sqr += delta * delta;
+  }
+
+  stats.count    = static_cast< size_t >( count );
+  stats.numNaN   = static_cast< size_t >( numNaN );
+  stats.numInf   = static_cast< size_t >( n - count - numNaN );
+  stats.min      = count > 0 ? lo : nan;
+  stats.max      = count > 0 ? hi : nan;
+  stats.sum      = sum;
+  stats.mean     = mean;
+  stats.variance = count > 0 ? sqr / count : nan;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Equal width bins over [lo, hi], last bin closed, each thread fills a
+///        private histogram merged at the end
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static size_t
+histogramTyped( const T *src, long long n, double lo, double hi, std::vector< int64_t > &counts )
+{
+  const long long numBins = static_cast< long long >( counts.size() );
+  const double    perBin  = numBins / ( hi - lo );
+  long long       numNaN  = 0;
+
+#ifdef _OPENMP
+  #pragma omp parallel reduction( + : numNaN )
+#endif
+  {
+    std::vector< int64_t > local( numBins, 0 );
+
+#ifdef _OPENMP
+    #pragma omp for nowait
+#endif
+    for ( long long i = 0; i < n; i++ )
+    {
+      double value = static_cast< double >( src[i] );
+      // Non-finite values never reach an ordered comparison, which would raise
+      // FE_INVALID for NaN on threads outside the caller's FPE guard
+      if ( !isFinite( value ) )
+      {
+        numNaN += isNaN( value ) ? 1 : 0;
+      }
+      else if ( value >= lo && value <= hi )
+      {
+        long long bin = static_cast< long long >( ( value - lo ) * perBin );
+        local[ bin < numBins ? bin : numBins - 1 ]++;
+      }
+    }
+
+#ifdef _OPENMP
+    #pragma omp critical
+#endif
+    for ( long long bin = 0; bin < numBins; bin++ )
+    {
+      counts[ bin ] += local[ bin ];
+    }
+  }
+  return static_cast< size_t >( numNaN );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief IEEE single to half precision bits with round to nearest even,
+///        overflow becomes inf and NaN stays NaN
+///
+/// Every case is computed and the result selected with masks, rather than
+/// conditionals the compiler may turn back into branches, so loops calling
+/// this vectorize
+////////////////////////////////////////////////////////////////////////////////
+static inline uint16_t
+halfBits( float value )
+{
+  uint32_t bits;
+  std::memcpy( &bits, &value, sizeof( bits ) );
+
+  uint32_t sign    = ( bits >> 16 ) & 0x8000;
+  uint32_t absBits = bits & 0x7fffffff;
+
+  // Normal, rebias exponent from 127 to 15 and round mantissa from 23 to 10 bits,
+  // values >= 65520 carry into the exponent and become inf
+  uint32_t normal = ( absBits - 0x38000000 + 0x0fff + ( ( absBits >> 13 ) & 1 ) ) >> 13;
+
+  // Below 2^-14, adding 0.5 makes the FPU round the mantissa into half subnormal position
+  uint32_t isTiny   = 0u - static_cast< uint32_t >( absBits < 0x38800000 );
+  uint32_t tinyBits = absBits & isTiny;
+  float    tiny;
+  std::memcpy( &tiny, &tinyBits, sizeof( tiny ) );
+  tiny += 0.5f;
+  uint32_t subnormal;
+  std::memcpy( &subnormal, &tiny, sizeof( subnormal ) );
+  subnormal -= 0x3f000000;
+
+  // inf or NaN, keep NaN quiet
+  uint32_t isHuge  = 0u - static_cast< uint32_t >( absBits >= 0x47800000 );
+  uint32_t special = 0x7c00 | ( static_cast< uint32_t >( absBits > 0x7f800000 ) << 9 );
+
+  uint32_t finite = ( subnormal & isTiny ) | ( normal & ~isTiny );
+  uint32_t half   = ( special   & isHuge ) | ( finite & ~isHuge );
+  return static_cast< uint16_t >( sign | half );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Convert to IEEE single precision
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void
+toFloat32( const T *src, float *dst, long long n )
+{
+  PARALLEL_FOR_SIMD
+  for ( long long i = 0; i < n; i++ )
+  {
+    dst[i] = static_cast< float >( src[i] );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Convert to IEEE half precision bits
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void
+toFloat16( const T *src, uint16_t *dst, long long n )
+{
+  PARALLEL_FOR_SIMD
+  for ( long long i = 0; i < n; i++ )
+  {
+    dst[i] = halfBits( static_cast< float >( src[i] ) );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Linear quantization, q = round( ( x - offset ) / scale ) clamped to Q,
+///        -inf and NaN map to 0 and +inf maps to the max of Q for any scale
+///
+/// Non-finite values are swapped for offset before any arithmetic or ordered
+/// comparison so no FE_INVALID is raised on the worker threads
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename Q >
+static void
+quantize( const T *src, Q *dst, long long n, double offset, double scale )
+{
+  const double levels  = static_cast< double >( std::numeric_limits< Q >::max() );
+  const double inverse = scale > 0.0 ? 1.0 / scale : 0.0;
+
+  PARALLEL_FOR_SIMD
+  for ( long long i = 0; i < n; i++ )
+  {
+    double value  = static_cast< double >( src[i] );
+    bool   finite = isFinite( value );
+    double q      = ( ( finite ? value : offset ) - offset ) * inverse + 0.5;
+    q = q > 0.0    ? q : 0.0;
+    q = q < levels ? q : levels;
+    q = finite ? q : ( isPositiveInf( value ) ? levels : 0.0 );
+    dst[i] = static_cast< Q >( q );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Dispatch to the requested conversion
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void
+reduceTyped( const T *src, long long n, int type, void *dst, double offset, double scale )
+{
+  switch ( type )
+  {
+    case ArrayKernels::FLOAT32 : toFloat32( src, static_cast< float    * >( dst ), n ); break;
+    case ArrayKernels::FLOAT16 : toFloat16( src, static_cast< uint16_t * >( dst ), n ); break;
+    case ArrayKernels::UINT16  : quantize ( src, static_cast< uint16_t * >( dst ), n, offset, scale ); break;
+    case ArrayKernels::UINT8   : quantize ( src, static_cast< uint8_t  * >( dst ), n, offset, scale ); break;
+    default : break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Reduced type from its numpy dtype name, -1 if not supported
+////////////////////////////////////////////////////////////////////////////////
+int
+ArrayKernels::reducedType(
+                          std::string name ///< numpy dtype name e.g. "float16"
+                          )
+{
+  if ( name == "float32" ) return FLOAT32;
+  if ( name == "float16" ) return FLOAT16;
+  if ( name == "uint16"  ) return UINT16;
+  if ( name == "uint8"   ) return UINT8;
+  return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief numpy dtype name of a reduced type
+////////////////////////////////////////////////////////////////////////////////
+std::string
+ArrayKernels::reducedName(
+                          int type ///< ArrayKernels::ReducedType
+                          )
+{
+  switch ( type )
+  {
+    case FLOAT32 : return "float32";
+    case FLOAT16 : return "float16";
+    case UINT16  : return "uint16";
+    case UINT8   : return "uint8";
+    default      : return "";
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Bytes per element of a reduced type
+////////////////////////////////////////////////////////////////////////////////
+size_t
+ArrayKernels::reducedItemSize(
+                              int type ///< ArrayKernels::ReducedType
+                              )
+{
+  switch ( type )
+  {
+    case FLOAT32 : return sizeof( float );
+    case FLOAT16 : return sizeof( uint16_t );
+    case UINT16  : return sizeof( uint16_t );
+    case UINT8   : return sizeof( uint8_t );
+    default      : return 0;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Whether a reduced type needs an offset and scale to be interpreted
+////////////////////////////////////////////////////////////////////////////////
+bool
+ArrayKernels::reducedQuantized(
+                                int type ///< ArrayKernels::ReducedType
+                                )
+{
+  return type == UINT16 || type == UINT8;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Convert src into dst of reducedItemSize( type ) * src.numElements() bytes,
+///        quantized values are recovered as offset + q * scale
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayKernels::reduce(
+                      const EmbeddedArray &src,    ///< array to convert
+                      int                  type,   ///< ArrayKernels::ReducedType to convert to
+                      void                *dst,    ///< output buffer
+                      double              &offset, ///< [out] quantization offset, 0 if not quantized
+                      double              &scale   ///< [out] quantization scale, 1 if not quantized
+                      )
+{
+  offset = 0.0;
+  scale  = 1.0;
+
+  if ( reducedQuantized( type ) )
+  {
+    double min, max;
+    size_t numFinite;
+    finiteMinMax( src, min, max, numFinite );
+
+    double levels = type == UINT8 ? std::numeric_limits< uint8_t >::max() : std::numeric_limits< uint16_t >::max();
+    offset = numFinite > 0 ? min                    : 0.0;
+    scale  = numFinite > 0 ? ( max - min ) / levels : 0.0;
+  }
+
+  long long n = static_cast< long long >( src.numElements() );
+  if      ( src.kind == 'f' && src.itemSize == sizeof( double  ) ) reduceTyped( static_cast< const double  * >( src.ptr ), n, type, dst, offset, scale );
+  else if ( src.kind == 'f' && src.itemSize == sizeof( float   ) ) reduceTyped( static_cast< const float   * >( src.ptr ), n, type, dst, offset, scale );
+  else if ( src.kind == 'i' && src.itemSize == sizeof( int32_t ) ) reduceTyped( static_cast< const int32_t * >( src.ptr ), n, type, dst, offset, scale );
+  else unsupported( src, __func__ );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Min and max of the finite values in src, +inf / -inf if none
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayKernels::finiteMinMax(
+                            const EmbeddedArray &src,      ///< array to scan
+                            double              &min,      ///< [out] minimum finite value
+                            double              &max,      ///< [out] maximum finite value
+                            size_t              &numFinite ///< [out] number of finite values
+                            )
+{
+  long long n = static_cast< long long >( src.numElements() );
+  if      ( src.kind == 'f' && src.itemSize == sizeof( double  ) ) finiteMinMaxTyped( static_cast< const double  * >( src.ptr ), n, min, max, numFinite );
+  else if ( src.kind == 'f' && src.itemSize == sizeof( float   ) ) finiteMinMaxTyped( static_cast< const float   * >( src.ptr ), n, min, max, numFinite );
+  else if ( src.kind == 'i' && src.itemSize == sizeof( int32_t ) ) finiteMinMaxTyped( static_cast< const int32_t * >( src.ptr ), n, min, max, numFinite );
+  else unsupported( src, __func__ );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Count, extrema, sum, mean, and variance of the finite values in src,
+///        NaN and inf are only counted
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayKernels::stats(
+                    const EmbeddedArray &src,  ///< array to scan
+                    Stats               &stats ///< [out] summary of src
+                    )
+{
+  long long n = static_cast< long long >( src.numElements() );
+  if      ( src.kind == 'f' && src.itemSize == sizeof( double  ) ) statsTyped( static_cast< const double  * >( src.ptr ), n, stats );
+  else if ( src.kind == 'f' && src.itemSize == sizeof( float   ) ) statsTyped( static_cast< const float   * >( src.ptr ), n, stats );
+  else if ( src.kind == 'i' && src.itemSize == sizeof( int32_t ) ) statsTyped( static_cast< const int32_t * >( src.ptr ), n, stats );
+  else unsupported( src, __func__ );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Histogram of src into counts.size() equal width bins over [lo, hi] as
+///        numpy.histogram, returns the number of NaN values which like values
+///        outside the range and inf are not counted in any bin
+////////////////////////////////////////////////////////////////////////////////
+size_t
+ArrayKernels::histogram(
+                        const EmbeddedArray    &src,   ///< array to scan
+                        double                  lo,    ///< lower edge of the first bin
+                        double                  hi,    ///< upper edge of the last bin, must exceed lo
+                        std::vector< int64_t > &counts ///< [in,out] sized to the number of bins, zeroed and filled
+                        )
+{
+  std::fill( counts.begin(), counts.end(), 0 );
+  if ( counts.empty() || !( hi > lo ) )
+  {
+    return 0;
+  }
+
+  long long n = static_cast< long long >( src.numElements() );
+  if      ( src.kind == 'f' && src.itemSize == sizeof( double  ) ) return histogramTyped( static_cast< const double  * >( src.ptr ), n, lo, hi, counts );
+  else if ( src.kind == 'f' && src.itemSize == sizeof( float   ) ) return histogramTyped( static_cast< const float   * >( src.ptr ), n, lo, hi, counts );
+  else if ( src.kind == 'i' && src.itemSize == sizeof( int32_t ) ) return histogramTyped( static_cast< const int32_t * >( src.ptr ), n, lo, hi, counts );
+  else unsupported( src, __func__ );
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief IEEE single to half precision bits with round to nearest even,
+///        overflow becomes inf and NaN stays NaN
+////////////////////////////////////////////////////////////////////////////////
+uint16_t
+ArrayKernels::floatToHalf(
+                          float value ///< value to convert
+                          )
+{
+  return halfBits( value );
+}
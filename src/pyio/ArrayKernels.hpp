@@ -0,0 +1,55 @@
+#ifndef ArrayKernels_hpp
+#define ArrayKernels_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "EmbeddedArray.hpp"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Native, OpenMP-parallel kernels operating directly on embedded arrays
+///        so python only sees small or reduced results
+////////////////////////////////////////////////////////////////////////////////
+class ArrayKernels
+{
+public:
+  enum ReducedType
+  {
+    FLOAT32 = 0, ///< IEEE single precision
+    FLOAT16 = 1, ///< IEEE half precision, round to nearest even
+    UINT16  = 2, ///< linear quantization over [min, max] of finite values
+    UINT8   = 3  ///< linear quantization over [min, max] of finite values
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Summary of an array, non-finite values are counted but otherwise ignored
+  //////////////////////////////////////////////////////////////////////////////
+  struct Stats
+  {
+    size_t count;    ///< number of finite values
+    size_t numNaN;   ///< number of NaN values
+    size_t numInf;   ///< number of +inf / -inf values
+    double min;      ///< minimum finite value, NaN if none
+    double max;      ///< maximum finite value, NaN if none
+    double sum;      ///< sum of finite values
+    double mean;     ///< mean of finite values, NaN if none
+    double variance; ///< population variance of finite values, NaN if none
+  };
+
+  static int         reducedType    ( std::string name );
+  static std::string reducedName    ( int type );
+  static size_t      reducedItemSize( int type );
+  static bool        reducedQuantized( int type );
+
+  static void   reduce      ( const EmbeddedArray &src, int type, void *dst, double &offset, double &scale );
+  static void   finiteMinMax( const EmbeddedArray &src, double &min, double &max, size_t &numFinite );
+  static void   stats       ( const EmbeddedArray &src, Stats &stats );
+  static size_t histogram   ( const EmbeddedArray &src, double lo, double hi, std::vector< int64_t > &counts );
+
+  static uint16_t floatToHalf( float value );
+};
+
+#endif
@@ -0,0 +1,374 @@
+#include "ArrayWriter.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Alignment of each array within a container, matches npy header alignment
+#define CONTAINER_ALIGNMENT 64
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ctor
+////////////////////////////////////////////////////////////////////////////////
+ArrayWriter::ArrayWriter()
+  : pending_( 0 ),
+    running_( false )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Dtor
+////////////////////////////////////////////////////////////////////////////////
+ArrayWriter::~ArrayWriter()
+{
+  stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a single array to a .npy file loadable with numpy.load( mmap_mode='r' )
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::writeNpy(
+                      const EmbeddedArray &array,    ///< array to write
+                      std::string          filename, ///< output .npy file
+                      int                  mode      ///< ArrayWriter::Mode to write with
+                      )
+{
+  Job job;
+  job.filename  = filename;
+  job.container = false;
+  job.arrays.push_back( std::make_pair( std::string(), array ) );
+  submit( job, mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a set of arrays to a single memory-mapped container file
+///
+/// Each array is stored as a complete .npy image aligned to CONTAINER_ALIGNMENT,
+/// and a text index "<filename>.index" lists per line :
+///   name dataOffset descr order(F|C) dim0,dim1,...
+/// such that numpy.memmap( filename, dtype=descr, mode='r', offset=dataOffset,
+/// shape=dims, order=order ) maps an array without any conversion
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::writeContainer(
+                            const NamedArrays &arrays,   ///< arrays to write with their names
+                            std::string        filename, ///< output container file
+                            int                mode      ///< ArrayWriter::Mode to write with
+                            )
+{
+  Job job;
+  job.filename  = filename;
+  job.container = true;
+  job.arrays    = arrays;
+  submit( job, mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Block until all queued asynchronous writes are complete, rethrows
+///        the first error raised by any of them since the last wait()
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::wait()
+{
+  std::unique_lock< std::mutex > lock( mutex_ );
+  while ( pending_ > 0 )
+  {
+    drained_.wait( lock );
+  }
+
+  if ( !error_.empty() )
+  {
+    std::string error;
+    error.swap( error_ );
+    throw std::runtime_error( error );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Finish all queued writes and join the writer thread
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::stop()
+{
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    running_ = false;
+  }
+  wakeup_.notify_all();
+
+  if ( thread_.joinable() )
+  {
+    thread_.join();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Build the .npy v1.0 preamble and header describing array
+////////////////////////////////////////////////////////////////////////////////
+std::string
+ArrayWriter::npyHeader(
+                        const EmbeddedArray &array ///< array to describe
+                        )
+{
+  std::stringstream dict;
+  dict << "{'descr': '" << array.descr() << "', "
+       << "'fortran_order': " << ( array.fortranOrder ? "True" : "False" ) << ", "
+       << "'shape': (";
+  for ( size_t i = 0; i < array.dims.size(); i++ )
+  {
+    dict << ( i > 0 ? ", " : "" ) << array.dims[i];
+  }
+  dict << ( array.dims.size() == 1 ? ",), }" : "), }" );
+
+  // magic string + version + uint16 header length
+  const size_t preambleSize = 10;
+
+  // Pad with spaces and terminate with newline so data starts aligned
+  std::string header   = dict.str();
+  size_t      unpadded = preambleSize + header.size() + 1;
+  size_t      padded   = ( ( unpadded + CONTAINER_ALIGNMENT - 1 ) / CONTAINER_ALIGNMENT ) * CONTAINER_ALIGNMENT;
+  header.append( padded - unpadded, ' ' );
+  header.push_back( '\n' );
+
+  if ( header.size() > UINT16_MAX )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: npy header too large for " << array.dims.size() << " dims" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  std::string preamble( "\x93NUMPY\x01\x00", 8 );
+  preamble.push_back( static_cast< char >(   header.size()        & 0xff ) );
+  preamble.push_back( static_cast< char >( ( header.size() >> 8 ) & 0xff ) );
+
+  return preamble + header;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Execute job now or hand it to the writer thread based on mode
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::submit(
+                    Job &job, ///< job to run, contents are moved if queued
+                    int  mode ///< ArrayWriter::Mode to write with
+                    )
+{
+  if ( mode != SYNC && mode != ASYNC && mode != ASYNC_SNAPSHOT )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Unknown array dump mode " << mode << " for '" << job.filename << "'" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  if ( mode == SYNC )
+  {
+    execute( job );
+    return;
+  }
+
+  if ( mode == ASYNC_SNAPSHOT )
+  {
+    job.snapshots.resize( job.arrays.size() );
+    for ( size_t i = 0; i < job.arrays.size(); i++ )
+    {
+      const char *data = static_cast< const char * >( job.arrays[i].second.ptr );
+      job.snapshots[i].assign( data, data + job.arrays[i].second.numBytes() );
+    }
+  }
+
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    if ( !running_ )
+    {
+      running_ = true;
+      thread_  = std::thread( &ArrayWriter::run, this );
+    }
+    jobs_.push_back( std::move( job ) );
+    pending_++;
+  }
+  wakeup_.notify_one();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writer thread loop, drains the queue before exiting on stop()
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::run()
+{
+  std::unique_lock< std::mutex > lock( mutex_ );
+  while ( running_ || !jobs_.empty() )
+  {
+    if ( jobs_.empty() )
+    {
+      wakeup_.wait( lock );
+      continue;
+    }
+
+    Job job = std::move( jobs_.front() );
+    jobs_.pop_front();
+
+    std::string error;
+    lock.unlock();
+    try
+    {
+      execute( job );
+    }
+    catch ( const std::exception &e )
+    {
+      // Held for the next wait(), execute already logged to std::cerr
+      error = e.what();
+    }
+    lock.lock();
+
+    if ( error_.empty() )
+    {
+      error_ = error;
+    }
+
+    pending_--;
+    if ( pending_ == 0 )
+    {
+      drained_.notify_all();
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Perform the I/O of a job, substituting snapshot data if present
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::execute(
+                      const Job &job ///< job to write
+                      )
+{
+  NamedArrays arrays = job.arrays;
+  for ( size_t i = 0; i < job.snapshots.size(); i++ )
+  {
+    arrays[i].second.ptr = const_cast< char * >( job.snapshots[i].data() );
+  }
+
+  if ( job.container )
+  {
+    executeContainer( arrays, job.filename );
+  }
+  else
+  {
+    executeNpy( arrays[0].second, job.filename );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write a single .npy file
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::executeNpy(
+                        const EmbeddedArray &array,   ///< array to write
+                        const std::string   &filename ///< output .npy file
+                        )
+{
+  std::string   header = npyHeader( array );
+  std::ofstream out( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+
+  out.write( header.data(), header.size() );
+  out.write( static_cast< const char * >( array.ptr ), array.numBytes() );
+
+  if ( !out )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Failed to write '" << filename << "'" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Write all arrays into a single file through a shared memory map
+////////////////////////////////////////////////////////////////////////////////
+void
+ArrayWriter::executeContainer(
+                              const NamedArrays &arrays,  ///< arrays to write with their names
+                              const std::string &filename ///< output container file
+                              )
+{
+  std::vector< std::string > headers( arrays.size() );
+  std::vector< size_t >      offsets( arrays.size() );
+  size_t                     totalSize = 0;
+
+  for ( size_t i = 0; i < arrays.size(); i++ )
+  {
+    headers[i] = npyHeader( arrays[i].second );
+    offsets[i] = totalSize;
+    totalSize += headers[i].size() + arrays[i].second.numBytes();
+    totalSize  = ( ( totalSize + CONTAINER_ALIGNMENT - 1 ) / CONTAINER_ALIGNMENT ) * CONTAINER_ALIGNMENT;
+  }
+
+  std::stringstream ss;
+  int fd = open( filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if ( fd < 0 || ( totalSize > 0 && ftruncate( fd, totalSize ) != 0 ) )
+  {
+    if ( fd >= 0 ) close( fd );
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Failed to create container '" << filename << "'" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  if ( totalSize > 0 )
+  {
+    void *map = mmap( 0, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+    if ( map == MAP_FAILED )
+    {
+      close( fd );
+      ss << __FILE__ << ":" << __LINE__ << " : Error: Failed to map container '" << filename << "'" << std::endl;
+      std::cerr << ss.str();
+      throw std::runtime_error( ss.str() );
+    }
+
+    char *base = static_cast< char * >( map );
+    for ( size_t i = 0; i < arrays.size(); i++ )
+    {
+      std::memcpy( base + offsets[i], headers[i].data(), headers[i].size() );
+      std::memcpy( base + offsets[i] + headers[i].size(), arrays[i].second.ptr, arrays[i].second.numBytes() );
+    }
+
+    msync( map, totalSize, MS_SYNC );
+    munmap( map, totalSize );
+  }
+  close( fd );
+
+  // Index for direct numpy.memmap access
+  std::ofstream index( ( filename + ".index" ).c_str(), std::ios::out | std::ios::trunc );
+  index << "# name dataOffset descr order shape" << std::endl;
+  for ( size_t i = 0; i < arrays.size(); i++ )
+  {
+    const EmbeddedArray &array = arrays[i].second;
+    index << arrays[i].first << " "
+          << offsets[i] + headers[i].size() << " "
+          << array.descr() << " "
+          << ( array.fortranOrder ? "F" : "C" ) << " ";
+    for ( size_t d = 0; d < array.dims.size(); d++ )
+    {
+      index << ( d > 0 ? "," : "" ) << array.dims[d];
+    }
+    index << std::endl;
+  }
+
+  if ( !index )
+  {
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Failed to write index '" << filename << ".index'" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+}
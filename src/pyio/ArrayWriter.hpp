@@ -0,0 +1,70 @@
+#ifndef ArrayWriter_hpp
+#define ArrayWriter_hpp
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EmbeddedArray.hpp"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writes embedded arrays natively to .npy files or a single memory-mapped
+///        container, optionally on a background thread so the caller need not
+///        wait on (or hold the GIL during) I/O
+////////////////////////////////////////////////////////////////////////////////
+class ArrayWriter
+{
+public:
+  enum Mode
+  {
+    SYNC           = 0, ///< Write in the calling thread, return once data is on disk
+    ASYNC          = 1, ///< Write from the live pointer on the writer thread, caller must wait() before modifying data
+    ASYNC_SNAPSHOT = 2  ///< Copy data into a snapshot buffer then write on the writer thread, caller may modify immediately
+  };
+
+  typedef std::vector< std::pair< std::string, EmbeddedArray > > NamedArrays;
+
+  // Ctor Dtor
+  ArrayWriter();
+  virtual ~ArrayWriter();
+
+  void writeNpy      ( const EmbeddedArray &array, std::string filename, int mode );
+  void writeContainer( const NamedArrays   &arrays, std::string filename, int mode );
+
+  void wait();
+  void stop();
+
+  static std::string npyHeader( const EmbeddedArray &array );
+
+private:
+  struct Job
+  {
+    std::string                        filename;  ///< output file
+    bool                               container; ///< write all arrays into one container, else a single .npy
+    NamedArrays                        arrays;    ///< arrays to write
+    std::vector< std::vector< char > > snapshots; ///< if not empty, data to write in place of arrays[i].ptr
+  };
+
+  void submit( Job &job, int mode );
+  void run();
+
+  static void execute         ( const Job &job );
+  static void executeNpy      ( const EmbeddedArray &array,  const std::string &filename );
+  static void executeContainer( const NamedArrays   &arrays, const std::string &filename );
+
+  std::thread              thread_;   ///< background writer, started on first asynchronous request
+  std::mutex               mutex_;    ///< guards jobs_, pending_, running_, and error_
+  std::condition_variable  wakeup_;   ///< signals writer that jobs are available or it should stop
+  std::condition_variable  drained_;  ///< signals waiters that all pending jobs are complete
+  std::deque< Job >        jobs_;     ///< queued asynchronous jobs
+  size_t                   pending_;  ///< jobs queued or in progress
+  bool                     running_;  ///< writer thread is alive
+  std::string              error_;    ///< first error raised on the writer thread since the last wait()
+};
+
+#endif
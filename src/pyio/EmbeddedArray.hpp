@@ -0,0 +1,114 @@
+#ifndef EmbeddedArray_hpp
+#define EmbeddedArray_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Native description of a raw array registered via embedPtr, enough to
+///        reinterpret its memory without going through python
+////////////////////////////////////////////////////////////////////////////////
+struct EmbeddedArray
+{
+  void                  *ptr;          ///< raw data, owned by the embedding caller
+  char                   kind;         ///< numpy type kind - 'f' floating point, 'i' signed, 'u' unsigned integer
+  size_t                 itemSize;     ///< size in bytes of a single element
+  bool                   fortranOrder; ///< column-major layout
+  std::vector< size_t >  dims;         ///< size of each dimension
+
+  uint64_t               version;      ///< bumped each time the embedding caller marks the data dirty
+  size_t                 dirtyBegin;   ///< first flat element marked dirty since last clean
+  size_t                 dirtyEnd;     ///< one past last flat element marked dirty since last clean, dirtyBegin == dirtyEnd if clean
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Total number of elements across all dims
+  ////////////////////////////////////////////////////////////////////////////////
+  size_t numElements() const
+  {
+    size_t num = 1;
+    for ( size_t i = 0; i < dims.size(); i++ )
+    {
+      num *= dims[i];
+    }
+    return num;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Total number of bytes backing the array
+  ////////////////////////////////////////////////////////////////////////////////
+  size_t numBytes() const
+  {
+    return numElements() * itemSize;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Bump the version and grow the dirty region to include [begin, end)
+  ////////////////////////////////////////////////////////////////////////////////
+  void markDirty( size_t begin, size_t end )
+  {
+    if ( end > numElements() )
+    {
+      end = numElements();
+    }
+    if ( begin >= end )
+    {
+      return;
+    }
+
+    if ( dirtyBegin == dirtyEnd )
+    {
+      dirtyBegin = begin;
+      dirtyEnd   = end;
+    }
+    else
+    {
+      dirtyBegin = begin < dirtyBegin ? begin : dirtyBegin;
+      dirtyEnd   = end   > dirtyEnd   ? end   : dirtyEnd;
+    }
+    version++;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief numpy array-protocol type string, e.g. '<f8'
+  ////////////////////////////////////////////////////////////////////////////////
+  std::string descr() const
+  {
+    const uint16_t endianCheck = 1;
+    std::stringstream ss;
+    ss << ( *reinterpret_cast< const char * >( &endianCheck ) ? '<' : '>' ) << kind << itemSize;
+    return ss.str();
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Describe a typed pointer as an EmbeddedArray
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+EmbeddedArray
+makeEmbeddedArray(
+                  T      *ptr,          ///< pointer to respective data to map, of element size PRODUCT(pDimSize) for numDims
+                  size_t  numDims,      ///< dimensionality of the array
+                  size_t *pDimSize,     ///< pointer of size numDims describing the respective size of each dim
+                  bool    fortranOrder  ///< column-major layout
+                  )
+{
+  static_assert( std::is_arithmetic< T >::value, "EmbeddedArray only describes arithmetic types" );
+
+  EmbeddedArray array;
+  array.ptr          = static_cast< void * >( ptr );
+  array.kind         = std::is_floating_point< T >::value ? 'f' : ( std::is_signed< T >::value ? 'i' : 'u' );
+  array.itemSize     = sizeof( T );
+  array.fortranOrder = fortranOrder;
+  array.dims         = std::vector< size_t >( pDimSize, pDimSize + numDims );
+  array.version      = 0;
+  array.dirtyBegin   = 0;
+  array.dirtyEnd     = 0;
+  return array;
+}
+
+#endif
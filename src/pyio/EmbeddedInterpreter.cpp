@@ -1,6 +1,11 @@
 
 #include "EmbeddedInterpreter.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <list>
 #include <sstream>
@@ -19,11 +24,38 @@
 #include "pybind11/embed.h"
 #include "pybind11/numpy.h"
 
+#include "ArrayKernels.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Rank of this process under common MPI launchers, 0 if not found
+////////////////////////////////////////////////////////////////////////////////
+static std::string
+processRank()
+{
+  const char *vars[] = { "PMI_RANK", "PMIX_RANK", "OMPI_COMM_WORLD_RANK", "MV2_COMM_WORLD_RANK", "SLURM_PROCID" };
+  for ( size_t i = 0; i < sizeof( vars ) / sizeof( vars[0] ); i++ )
+  {
+    const char *rank = std::getenv( vars[i] );
+    if ( rank )
+    {
+      return std::string( rank );
+    }
+  }
+  return "0";
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief Ctor
 ////////////////////////////////////////////////////////////////////////////////
 EmbeddedInterpreter::EmbeddedInterpreter()
-  : autoLoad_( false )
+  : memoryTracking_( false ),
+    trackedCalls_( 0 ),
+    trackedOverlap_( false ),
+    tracingStarted_( false ),
+    epoch_( 0 ),
+    recordCalls_( 0 ),
+    recordedCalls_( 0 ),
+    autoLoad_( false )
 {
 }
 
@@ -65,12 +97,56 @@ EmbeddedInterpreter::initialize()
 void
 EmbeddedInterpreter::finalize()
 {
+  // Flush any outstanding asynchronous output, an error is raised once everything else is shut down
+  std::string dumpError;
+  try
+  {
+    arrayWriter_.wait();
+  }
+  catch ( const std::exception &e )
+  {
+    dumpError = e.what();
+  }
+  arrayWriter_.stop();
+
+  recordStop();
+
+  reportCallStats();
+  reportValueCaches();
+
+  for ( std::map< std::string, std::unique_ptr< OutputChannel > >::iterator it = channels_.begin(); it != channels_.end(); ++it )
+  {
+    if ( it->second->dropped() > 0 || it->second->pending() > 0 )
+    {
+      std::cerr << "Warning: Channel '" << it->first << "' dropped " << it->second->dropped() << " records, "
+                << it->second->pending() << " never drained" << std::endl;
+    }
+  }
+
+  profilerStop();
+  if ( !profilePrefix_.empty() )
+  {
+    std::string filename = profilePrefix_ + "." + processRank() + ".folded";
+    if ( profiler_.write( filename ) )
+    {
+      std::cout << "Python stack samples written to '" << filename << "'" << std::endl;
+    }
+  }
+
   // Clear containers
   {
     userDirectories_.clear();
     pymodules_.clear();
+    pendingAttrs_.clear();
   }
 
+  if ( !dumpError.empty() )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Asynchronous array dump failed before finalize : " << dumpError;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -147,19 +223,34 @@ EmbeddedInterpreter::addToScope(
 {
   userDirectories_.push_back( directory );
   sysPathAppend_( directory );
+
+  if ( recorder_.isOpen() )
+  {
+    recorder_.scope( directory );
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \brief "Creates" imports of the base modules provided
+/// \brief Makes an embedded module available to python, creating it at runtime
+///        unless compiled in with PYBIND11_EMBEDDED_MODULE
+///
+/// Attributes embedded into the module afterwards are only defined once python
+/// first accesses them
 ////////////////////////////////////////////////////////////////////////////////
 void
 EmbeddedInterpreter::embeddedPymoduleLoad(
-                                          std::string pymodule ///< Python module to operate on
+                                          std::string pymodule ///< Python module to operate on, may be dotted e.g. "ocean.fields"
                                           )
 {
   FPE_GUARD_START( fpeTemp );
-  pymodulesEmbedded_[ pymodule ] = pybind11::module_::import( pymodule.c_str() );
+  pymodulesEmbedded_[ pymodule ] = createEmbeddedModule( pymodule );
+  embedLazyAttributes( pymodule );
   FPE_GUARD_STOP( fpeTemp );
+
+  if ( recorder_.isOpen() )
+  {
+    recorder_.embeddedLoad( pymodule );
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -175,6 +266,11 @@ EmbeddedInterpreter::pymoduleLoad(
   FPE_GUARD_STOP( fpeTemp );
 
   pymodules_[ pymodule ] = loaded;
+
+  if ( recorder_.isOpen() )
+  {
+    recorder_.moduleLoad( pymodule );
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -186,45 +282,1229 @@ EmbeddedInterpreter::pymoduleCall(
                                   std::string function  ///< function name to invoke within pymodule
                                   )
 {
-  FPE_GUARD_START( fpeTemp );
-  if ( pybind11::hasattr( pymodules_[ pymodule ], function.c_str() ) )
+  FPE_GUARD_START( fpeTemp );
+  if ( pybind11::hasattr( pymodules_[ pymodule ], function.c_str() ) )
+  {
+    std::string key           = pymodule + ":" + function;
+    size_t      tracedAt      = 0;
+    bool        tracked       = memoryTracking_;
+    bool        accountMemory = false;
+
+    if ( tracked )
+    {
+      // The tracemalloc peak is process wide, so a call is only accounted if no
+      // other pymoduleCall, e.g. from another OpenMP thread, overlaps any of it
+      accountMemory = trackedCalls_ == 0;
+      if ( accountMemory )
+      {
+        // Only traced while accounted calls are in flight, so the rest of the run does not pay for it
+        if ( !tracemalloc_.attr( "is_tracing" )().cast< bool >() )
+        {
+          tracemalloc_.attr( "start" )();
+          tracingStarted_ = true;
+        }
+        trackedOverlap_ = false;
+        tracemalloc_.attr( "reset_peak" )();
+        profiler_.resetTracedPeak();
+        tracedAt = tracemalloc_.attr( "get_traced_memory" )().cast< pybind11::tuple >()[0].cast< size_t >();
+      }
+      else
+      {
+        trackedOverlap_ = true;
+      }
+      trackedCalls_++;
+    }
+
+    if ( recorder_.isOpen() )
+    {
+      // Only arrays that changed since last recorded are written
+      for ( std::map< std::string, std::map< std::string, EmbeddedArray > >::iterator mod = embeddedArrays_.begin(); mod != embeddedArrays_.end(); ++mod )
+      {
+        for ( std::map< std::string, EmbeddedArray >::iterator array = mod->second.begin(); array != mod->second.end(); ++array )
+        {
+          recorder_.data( mod->first, array->first, array->second );
+        }
+      }
+      recorder_.call( pymodule, function );
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    profiler_.callEnter( key );
+    try
+    {
+      pymodules_[ pymodule ].attr( function.c_str() )();
+    }
+    catch ( ... )
+    {
+      // Failed calls are timed and counted, their allocation is not accounted
+      profiler_.callExit();
+      recordCallTime( key, start, true );
+      if ( tracked ) trackedCallExit();
+      FPE_GUARD_STOP( fpeTemp );
+      throw;
+    }
+    profiler_.callExit();
+    recordCallTime( key, start, false );
+
+    // Read while still counted in flight so no other call can start in between
+    bool   accounted = accountMemory && !trackedOverlap_;
+    size_t current   = 0;
+    size_t peak      = 0;
+    if ( accounted )
+    {
+      // The sampler keeps its own allocations out of the peak, handing back the peak it displaced
+      pybind11::tuple traced = tracemalloc_.attr( "get_traced_memory" )().cast< pybind11::tuple >();
+      current = traced[0].cast< size_t >();
+      peak    = std::max( traced[1].cast< size_t >(), profiler_.tracedPeak() ) - tracedAt;
+    }
+    if ( tracked ) trackedCallExit();
+
+    if ( recorder_.isOpen() && ++recordedCalls_ == recordCalls_ )
+    {
+      recordStop();
+    }
+
+    if ( accounted )
+    {
+      CallStats &stats = callStats_[ key ];
+
+      stats.memoryCalls++;
+      stats.peakBytes      = peak > stats.peakBytes ? peak : stats.peakBytes;
+      stats.retainedBytes += static_cast< long long >( current ) - static_cast< long long >( tracedAt );
+
+      // Most specific budget wins
+      std::map< std::string, MemoryBudget >::iterator budget = memoryBudgets_.find( key );
+      if ( budget == memoryBudgets_.end() ) budget = memoryBudgets_.find( pymodule + ":" );
+      if ( budget == memoryBudgets_.end() ) budget = memoryBudgets_.find( ":" );
+
+      if ( budget != memoryBudgets_.end() && peak > budget->second.bytes )
+      {
+        stats.overBudget++;
+
+        std::stringstream ss;
+        ss << "Python module '" << pymodule << "' function '" << function << "' "
+           << "allocated a peak of " << peak << " bytes, exceeding budget of " << budget->second.bytes << " bytes";
+        if ( budget->second.action == BUDGET_FAIL )
+        {
+          FPE_GUARD_STOP( fpeTemp );
+          ss << std::endl;
+          std::stringstream err;
+          err << __FILE__ << ":" << __LINE__ << " : Error: " << ss.str();
+          std::cerr << err.str();
+          throw std::runtime_error( err.str() );
+        }
+        std::cout << "Warning: " << ss.str() << std::endl;
+      }
+    }
+  }
+  else
+  {
+    std::cout << "Warning: Python module '"      << pymodule 
+              << "' does not contain function '" << function 
+              << "', not executed." << std::endl;
+  }
+  FPE_GUARD_STOP( fpeTemp );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Enables tracking of python allocation per pymoduleCall via tracemalloc
+///
+/// tracemalloc keeps a single process wide peak, so only calls that neither
+/// start nor run while another pymoduleCall is in flight are accounted. Calls
+/// running concurrently, e.g. between threadingStart and threadingStop, are
+/// still timed and reported as not accounted. Tracing is only on while tracked
+/// calls are in flight, unless python itself started it
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::memoryTracking(
+                                    bool enable ///< start or stop tracking
+                                    )
+{
+  if ( !tracemalloc_ )
+  {
+    tracemalloc_ = pybind11::module_::import( "tracemalloc" );
+  }
+
+  if ( enable && !pybind11::hasattr( tracemalloc_, "reset_peak" ) )
+  {
+    // Without per-call peak reset numbers would be meaningless
+    std::cout << "Warning: tracemalloc.reset_peak() requires python >= 3.9, memory tracking not enabled" << std::endl;
+    enable = false;
+  }
+
+  memoryTracking_ = enable;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ends a tracked pymoduleCall, stopping tracemalloc once the last one
+///        in flight is done if it was started for them
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::trackedCallExit()
+{
+  trackedCalls_--;
+  if ( trackedCalls_ == 0 && tracingStarted_ )
+  {
+    tracingStarted_ = false;
+    tracemalloc_.attr( "stop" )();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Sets a budget on the python allocation peak of a single pymoduleCall,
+///        only checked while memoryTracking is enabled
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::memoryBudget(
+                                  std::string pymodule, ///< Python module the budget applies to, empty for all
+                                  std::string function, ///< function name the budget applies to, empty for all in pymodule
+                                  size_t      bytes,    ///< peak bytes allowed above the starting traced size of a call
+                                  int         action    ///< EmbeddedInterpreter::BudgetAction when exceeded
+                                  )
+{
+  MemoryBudget budget;
+  budget.bytes  = bytes;
+  budget.action = action;
+  memoryBudgets_[ pymodule + ":" + ( pymodule.empty() ? std::string() : function ) ] = budget;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Sets how a value from embedValueFunc / embedValueCase is cached,
+///        any currently cached value is discarded
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::valueCache(
+                                std::string pymodule, ///< Python module the value was embedded in
+                                std::string attr,     ///< python attribute of the value
+                                int         policy    ///< EmbeddedInterpreter::CachePolicy
+                                )
+{
+  std::map< std::string, std::shared_ptr< ValueCache > >::iterator it = valueCaches_.find( pymodule + "." + attr );
+  if ( it == valueCaches_.end() || ( policy != CACHE_ALWAYS && policy != CACHE_ONCE && policy != CACHE_EPOCH ) )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Cannot set cache policy " << policy << " of '" << pymodule << "." << attr << "', "
+       << "must be a value from embedValueFunc or embedValueCase" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  it->second->policy = policy;
+  it->second->valid  = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Invalidates all CACHE_EPOCH values, next python read of each
+///        re-evaluates it
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::advanceEpoch()
+{
+  epoch_.fetch_add( 1, std::memory_order_relaxed );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Records emitted to a channel and not yet drained
+////////////////////////////////////////////////////////////////////////////////
+size_t
+EmbeddedInterpreter::channelPending(
+                                    std::string pymodule, ///< Python module providing emit()
+                                    std::string channel   ///< channel name used from python
+                                    )
+{
+  return findChannel( pymodule, channel ).pending();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Starts sampling python stacks while pymoduleCall is in flight
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::profilerStart(
+                                    double      hz,     ///< samples per second, keep low (e.g. 10-100) for production runs
+                                    std::string prefix  ///< output written to <prefix>.<rank>.folded at finalize
+                                    )
+{
+  profilePrefix_ = prefix;
+  profiler_.start( hz );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Stops sampling python stacks, samples are kept for finalize
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::profilerStop()
+{
+  profiler_.stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Starts recording a trace of embedded data, values returned to python,
+///        and pymoduleCall invocations for offline replay with pyio_replay
+///
+/// State that already exists (scope, loaded modules, and array layouts) is
+/// written first so the trace is self-contained
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::recordStart(
+                                  std::string filename, ///< trace file
+                                  size_t      numCalls  ///< pymoduleCall invocations to record, 0 for all until recordStop
+                                  )
+{
+  recordStop();
+  recorder_.open( filename );
+  recordFile_    = filename;
+  recordCalls_   = numCalls;
+  recordedCalls_ = 0;
+
+  for ( size_t i = 0; i < userDirectories_.size(); i++ )
+  {
+    recorder_.scope( userDirectories_[i] );
+  }
+  for ( std::unordered_map< std::string, pybind11::module_ >::iterator it = pymodulesEmbedded_.begin(); it != pymodulesEmbedded_.end(); ++it )
+  {
+    recorder_.embeddedLoad( it->first );
+  }
+  for ( std::map< std::string, std::map< std::string, EmbeddedArray > >::iterator mod = embeddedArrays_.begin(); mod != embeddedArrays_.end(); ++mod )
+  {
+    for ( std::map< std::string, EmbeddedArray >::iterator array = mod->second.begin(); array != mod->second.end(); ++array )
+    {
+      recorder_.array( mod->first, array->first, array->second );
+    }
+  }
+  for ( std::unordered_map< std::string, pybind11::module_ >::iterator it = pymodules_.begin(); it != pymodules_.end(); ++it )
+  {
+    recorder_.moduleLoad( it->first );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Stops recording and closes the trace
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::recordStop()
+{
+  if ( recorder_.isOpen() )
+  {
+    recorder_.close();
+    std::cout << "Trace of " << recordedCalls_ << " calls written to '" << recordFile_ << "'" << std::endl;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Accumulates the wall time of a finished pymoduleCall
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::recordCallTime(
+                                    const std::string                     &key,   ///< "pymodule:function" called
+                                    std::chrono::steady_clock::time_point  start, ///< time the call started
+                                    bool                                   failed ///< call raised
+                                    )
+{
+  double     elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+  CallStats &stats   = callStats_[ key ];
+
+  stats.calls++;
+  stats.failures  += failed ? 1 : 0;
+  stats.seconds   += elapsed;
+  stats.maxSeconds = elapsed > stats.maxSeconds ? elapsed : stats.maxSeconds;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Prints accumulated pymoduleCall accounting
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::reportCallStats()
+{
+  if ( callStats_.empty() )
+  {
+    return;
+  }
+
+  // Calls tracked earlier in the run are reported even if tracking has since been turned off
+  bool memory = false;
+  for ( std::map< std::string, CallStats >::iterator it = callStats_.begin(); it != callStats_.end(); ++it )
+  {
+    memory = memory || it->second.memoryCalls > 0;
+  }
+
+  const double mib = 1024.0 * 1024.0;
+  std::stringstream ss;
+  ss << "pymoduleCall statistics :" << std::endl
+     << std::left  << std::setw( 40 ) << "  module:function"
+     << std::right << std::setw( 8 )  << "calls"
+     << std::setw( 8 )  << "failed"
+     << std::setw( 14 ) << "total (s)"
+     << std::setw( 14 ) << "mean (s)"
+     << std::setw( 14 ) << "max (s)";
+  if ( memory )
+  {
+    ss << std::setw( 12 ) << "accounted"
+       << std::setw( 14 ) << "peak (MiB)"
+       << std::setw( 16 ) << "retained (MiB)"
+       << std::setw( 12 ) << "overBudget";
+  }
+  ss << std::endl;
+
+  for ( std::map< std::string, CallStats >::iterator it = callStats_.begin(); it != callStats_.end(); ++it )
+  {
+    const CallStats &stats = it->second;
+    ss << std::left  << std::setw( 40 ) << ( "  " + it->first )
+       << std::right << std::setw( 8 )  << stats.calls
+       << std::setw( 8 )  << stats.failures
+       << std::scientific << std::setprecision( 4 )
+       << std::setw( 14 ) << stats.seconds
+       << std::setw( 14 ) << stats.seconds / stats.calls
+       << std::setw( 14 ) << stats.maxSeconds
+       << std::fixed << std::setprecision( 3 );
+    if ( memory )
+    {
+      ss << std::setw( 12 ) << stats.memoryCalls
+         << std::setw( 14 ) << stats.peakBytes / mib
+         << std::setw( 16 ) << stats.retainedBytes / mib
+         << std::setw( 12 ) << stats.overBudget;
+    }
+    ss << std::endl;
+  }
+  std::cout << ss.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Prints hits and misses of values read from python
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::reportValueCaches()
+{
+  static const char *policyNames[] = { "always", "once", "epoch" };
+
+  std::stringstream ss;
+  for ( std::map< std::string, std::shared_ptr< ValueCache > >::iterator it = valueCaches_.begin(); it != valueCaches_.end(); ++it )
+  {
+    const ValueCache &cache = *it->second;
+    if ( cache.hits + cache.misses == 0 )
+    {
+      continue;
+    }
+    ss << std::left  << std::setw( 40 ) << ( "  " + it->first )
+       << std::right << std::setw( 8 )  << policyNames[ cache.policy ]
+       << std::setw( 12 ) << cache.hits
+       << std::setw( 12 ) << cache.misses
+       << std::endl;
+  }
+  if ( ss.str().empty() )
+  {
+    return;
+  }
+
+  std::cout << "Embedded value caching :" << std::endl
+            << std::left  << std::setw( 40 ) << "  module.attr"
+            << std::right << std::setw( 8 )  << "policy"
+            << std::setw( 12 ) << "hits"
+            << std::setw( 12 ) << "misses"
+            << std::endl
+            << ss.str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writes an array registered with embedPtr to a .npy file, bypassing python
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::arrayDump(
+                                std::string pymodule, ///< Python module the array was embedded in
+                                std::string attr,     ///< python attribute of the array
+                                std::string filename, ///< output .npy file
+                                int         mode      ///< ArrayWriter::Mode to write with
+                                )
+{
+  EmbeddedArray array;
+  {
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    array = findEmbeddedArray( pymodule, attr );
+  }
+  arrayWriter_.writeNpy( array, filename, mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writes all arrays registered with embedPtr in a module to
+///        <directory>/<pymodule>.<attr>.npy, bypassing python
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::arrayDumpModule(
+                                      std::string pymodule,  ///< Python module the arrays were embedded in
+                                      std::string directory, ///< existing output directory
+                                      int         mode       ///< ArrayWriter::Mode to write with
+                                      )
+{
+  checkEmbeddedModuleLoaded( pymodule );
+
+  // Copied under the lock, written without it
+  std::map< std::string, EmbeddedArray > arrays;
+  {
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    arrays = embeddedArrays_[ pymodule ];
+  }
+  for ( std::map< std::string, EmbeddedArray >::iterator it = arrays.begin(); it != arrays.end(); ++it )
+  {
+    arrayWriter_.writeNpy( it->second, directory + "/" + pymodule + "." + it->first + ".npy", mode );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writes a set of arrays registered with embedPtr into a single
+///        memory-mapped container, see ArrayWriter::writeContainer for layout
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::arrayDumpContainer(
+                                        std::string                pymodule, ///< Python module the arrays were embedded in
+                                        std::vector< std::string > attrs,    ///< python attributes of the arrays, empty for all in pymodule
+                                        std::string                filename, ///< output container file
+                                        int                        mode      ///< ArrayWriter::Mode to write with
+                                        )
+{
+  checkEmbeddedModuleLoaded( pymodule );
+
+  // Copied under the lock, written without it
+  ArrayWriter::NamedArrays named;
+  {
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    if ( attrs.empty() )
+    {
+      std::map< std::string, EmbeddedArray > &arrays = embeddedArrays_[ pymodule ];
+      for ( std::map< std::string, EmbeddedArray >::iterator it = arrays.begin(); it != arrays.end(); ++it )
+      {
+        attrs.push_back( it->first );
+      }
+    }
+
+    for ( size_t i = 0; i < attrs.size(); i++ )
+    {
+      named.push_back( std::make_pair( attrs[i], findEmbeddedArray( pymodule, attrs[i] ) ) );
+    }
+  }
+  arrayWriter_.writeContainer( named, filename, mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Blocks until all asynchronous array output is on disk, rethrowing
+///        the first asynchronous write error
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::arrayDumpWait()
+{
+  arrayWriter_.wait();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Marks all of an array registered with embedPtr as changed
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::markDirty(
+                                std::string pymodule, ///< Python module the array was embedded in
+                                std::string attr      ///< python attribute of the array
+                                )
+{
+  std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+  EmbeddedArray &array = findEmbeddedArray( pymodule, attr );
+  array.markDirty( 0, array.numElements() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Marks a flat element range of an array registered with embedPtr as changed
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::markDirtyRange(
+                                    std::string pymodule, ///< Python module the array was embedded in
+                                    std::string attr,     ///< python attribute of the array
+                                    size_t      begin,    ///< first flat element (0-based, memory order) changed
+                                    size_t      end       ///< one past the last flat element changed
+                                    )
+{
+  std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+  findEmbeddedArray( pymodule, attr ).markDirty( begin, end );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Current version of an array registered with embedPtr
+////////////////////////////////////////////////////////////////////////////////
+uint64_t
+EmbeddedInterpreter::arrayVersion(
+                                  std::string pymodule, ///< Python module the array was embedded in
+                                  std::string attr      ///< python attribute of the array
+                                  )
+{
+  std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+  return findEmbeddedArray( pymodule, attr ).version;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Checks if the embedded python module has been loaded and reports findings
+///        if necessary or simply loads
+////////////////////////////////////////////////////////////////////////////////
+bool
+EmbeddedInterpreter::checkEmbeddedModuleLoaded(
+                                                std::string pymodule ///< Python module to operate on
+                                                )
+{
+  if ( pymodulesEmbedded_.find( pymodule ) == pymodulesEmbedded_.end() )
+  {
+    if ( autoLoad_ )
+    {
+      embeddedPymoduleLoad( pymodule );
+    }
+    else
+    {
+      std::stringstream ss;
+      ss << __FILE__ << ":" << __LINE__ << " : Error: Module '" << pymodule << "' has not beed loaded" << std::endl;
+      std::cerr << ss.str();
+      throw std::runtime_error( ss.str() );
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Finds or creates an embedded module and inserts it into sys.modules
+///
+/// Modules compiled in are used as is, as are modules this created earlier.
+/// Any other module already imported is rejected rather than taken over.
+/// Otherwise an empty module is created without searching sys.path, so a user
+/// module of the same name is never picked up. The parent of a dotted name is
+/// imported if it exists, else created as an empty package
+////////////////////////////////////////////////////////////////////////////////
+pybind11::module_
+EmbeddedInterpreter::createEmbeddedModule(
+                                          std::string pymodule ///< Python module to provide
+                                          )
+{
+  if ( sys_.attr( "builtin_module_names" ).attr( "__contains__" )( pymodule ).cast< bool >() )
+  {
+    return pybind11::module_::import( pymodule.c_str() );
+  }
+
+  pybind11::dict modules = sys_.attr( "modules" ).cast< pybind11::dict >();
+  if ( modules.contains( pymodule.c_str() ) )
+  {
+    pybind11::module_ existing = pybind11::reinterpret_borrow< pybind11::module_ >( modules[ pymodule.c_str() ] );
+    if ( !pybind11::hasattr( existing, "__pyio_embedded__" ) )
+    {
+      std::stringstream ss;
+      ss << __FILE__ << ":" << __LINE__ << " : Error: Module '" << pymodule << "' is already imported and not an embedded module" << std::endl;
+      std::cerr << ss.str();
+      throw std::runtime_error( ss.str() );
+    }
+    return existing;
+  }
+
+  pybind11::module_ mod = pybind11::reinterpret_borrow< pybind11::module_ >(
+                                                                            pybind11::module_::import( "types" ).attr( "ModuleType" )( pymodule, "Embedded module created at runtime" )
+                                                                            );
+  mod.attr( "__pyio_embedded__" ) = true;
+
+  size_t dot = pymodule.rfind( '.' );
+  if ( dot != std::string::npos )
+  {
+    std::string       parentName = pymodule.substr( 0, dot );
+    pybind11::module_ parent;
+    try
+    {
+      parent = pybind11::module_::import( parentName.c_str() );
+    }
+    catch ( pybind11::error_already_set &e )
+    {
+      if ( !e.matches( PyExc_ImportError ) )
+      {
+        throw;
+      }
+      parent = createEmbeddedModule( parentName );
+      parent.attr( "__path__" ) = pybind11::list();
+    }
+    parent.attr( pymodule.substr( dot + 1 ).c_str() ) = mod;
+  }
+
+  modules[ pymodule.c_str() ] = mod;
+  return mod;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Gives an embedded module a module-level __getattr__ / __dir__ that
+///        define pending attributes upon first access
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::embedLazyAttributes(
+                                          std::string pymodule ///< Python module to operate on
+                                          )
+{
+  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+
+  // Only called for names not already in the module
+  mod.def(
+          "__getattr__",
+          [=]( std::string attr )
+          {
+            // find, not operator[], so lookups of missing names never grow pendingAttrs_
+            std::map< std::string, std::map< std::string, std::function< void( pybind11::module_ & ) > > >::iterator module = pendingAttrs_.find( pymodule );
+            if ( module == pendingAttrs_.end() || module->second.find( attr ) == module->second.end() )
+            {
+              throw pybind11::attribute_error( "module '" + pymodule + "' has no attribute '" + attr + "'" );
+            }
+
+            // Only forgotten once defined, a failed definition raises again on the next access
+            std::function< void( pybind11::module_ & ) > define = module->second.find( attr )->second;
+            pybind11::module_                            self   = pymodulesEmbedded_[ pymodule ];
+            define( self );
+            module->second.erase( attr );
+            return pybind11::object( self.attr( attr.c_str() ) );
+          }
+          );
+
+  mod.def(
+          "__dir__",
+          [=]()
+          {
+            pybind11::module_ self  = pymodulesEmbedded_[ pymodule ];
+            pybind11::list    names = pybind11::list( pybind11::object( self.attr( "__dict__" ) ) );
+
+            std::map< std::string, std::map< std::string, std::function< void( pybind11::module_ & ) > > >::iterator module = pendingAttrs_.find( pymodule );
+            if ( module == pendingAttrs_.end() )
+            {
+              return names;
+            }
+            for ( std::map< std::string, std::function< void( pybind11::module_ & ) > >::iterator it = module->second.begin(); it != module->second.end(); ++it )
+            {
+              names.append( pybind11::str( it->first ) );
+            }
+            return names;
+          }
+          );
+}
+
+// Helpers provided eagerly by embedArrayHelpers / embedChannelHelpers
+static const char *arrayHelperNames[]   = { "version", "dirty", "clean", "memoize", "reduced", "stats", "histogram" };
+static const char *channelHelperNames[] = { "emit" };
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Rejects attribute names a helper of the module would hide, only the
+///        helpers the module has been given are reserved
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::checkAttrName(
+                                    std::string pymodule, ///< Python module to operate on
+                                    std::string attr      ///< python attribute to be embedded
+                                    )
+{
+  bool reserved = attr == "__getattr__" || attr == "__dir__";
+  if ( arrayHelpersEmbedded_.count( pymodule ) )
+  {
+    for ( size_t i = 0; i < sizeof( arrayHelperNames ) / sizeof( arrayHelperNames[0] ); i++ )
+    {
+      reserved = reserved || attr == arrayHelperNames[i];
+    }
+  }
+  if ( channelHelpersEmbedded_.count( pymodule ) )
+  {
+    for ( size_t i = 0; i < sizeof( channelHelperNames ) / sizeof( channelHelperNames[0] ); i++ )
+    {
+      reserved = reserved || attr == channelHelperNames[i];
+    }
+  }
+
+  if ( reserved )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Cannot embed '" << pymodule << "." << attr << "', name is reserved for a module helper" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Rejects giving a module helpers that would hide attributes already
+///        embedded or set on it
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::checkHelperNames(
+                                      std::string        pymodule, ///< Python module to operate on
+                                      const char *const *names,    ///< helper names about to be defined
+                                      size_t             numNames  ///< number of names
+                                      )
+{
+  pybind11::dict                                                                                   dict    = pymodulesEmbedded_[ pymodule ].attr( "__dict__" ).cast< pybind11::dict >();
+  std::map< std::string, std::map< std::string, std::function< void( pybind11::module_ & ) > > >::iterator pending = pendingAttrs_.find( pymodule );
+  for ( size_t i = 0; i < numNames; i++ )
+  {
+    if ( dict.contains( names[i] ) || ( pending != pendingAttrs_.end() && pending->second.count( names[i] ) ) )
+    {
+      std::stringstream ss;
+      ss << __FILE__ << ":" << __LINE__ << " : Error: Cannot provide helper '" << names[i] << "' to '" << pymodule << "', the name is already embedded" << std::endl;
+      std::cerr << ss.str();
+      throw std::runtime_error( ss.str() );
+    }
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Defines an attribute of an embedded module upon first python access,
+///        or immediately if python already holds a previous definition
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::defineAttr(
+                                std::string                                  pymodule, ///< Python module to operate on
+                                std::string                                  attr,     ///< python attribute to define
+                                std::function< void( pybind11::module_ & ) > define    ///< defines attr on the module given
+                                )
+{
+  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+  if ( mod.attr( "__dict__" ).cast< pybind11::dict >().contains( attr.c_str() ) )
+  {
+    define( mod );
+    return;
+  }
+  pendingAttrs_[ pymodule ][ attr ] = define;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Finds the native description of an array registered with embedPtr
+////////////////////////////////////////////////////////////////////////////////
+EmbeddedArray &
+EmbeddedInterpreter::findEmbeddedArray(
+                                        std::string pymodule, ///< Python module the array was embedded in
+                                        std::string attr      ///< python attribute of the array
+                                        )
+{
+  std::map< std::string, std::map< std::string, EmbeddedArray > >::iterator mod = embeddedArrays_.find( pymodule );
+  if ( mod == embeddedArrays_.end() || mod->second.find( attr ) == mod->second.end() )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Attribute '" << pymodule << "." << attr << "' is not an embedded array" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+  return mod->second.find( attr )->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Finds a channel created with channelCreate
+////////////////////////////////////////////////////////////////////////////////
+OutputChannel &
+EmbeddedInterpreter::findChannel(
+                                  std::string pymodule, ///< Python module providing emit()
+                                  std::string channel   ///< channel name used from python
+                                  )
+{
+  std::map< std::string, std::unique_ptr< OutputChannel > >::iterator it = channels_.find( pymodule + "." + channel );
+  if ( it == channels_.end() )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Channel '" << channel << "' was not created in '" << pymodule << "'" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+  return *it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Provides emit() to an embedded module, done once per module upon
+///        first channelCreate
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::embedChannelHelpers(
+                                          std::string pymodule ///< Python module to operate on
+                                          )
+{
+  if ( channelHelpersEmbedded_.count( pymodule ) )
+  {
+    return;
+  }
+  checkHelperNames( pymodule, channelHelperNames, sizeof( channelHelperNames ) / sizeof( channelHelperNames[0] ) );
+  channelHelpersEmbedded_.insert( pymodule );
+
+  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+
+  // pymodule.emit( "channel", records ) -> accepted
+  mod.def(
+          "emit",
+          [=]( std::string channel, pybind11::object records )
+          {
+            OutputChannel &out = findChannel( pymodule, channel );
+            if      ( out.kind() == 'f' && out.itemSize() == sizeof( double  ) ) return channelEmit< double  >( out, records );
+            else if ( out.kind() == 'f' && out.itemSize() == sizeof( float   ) ) return channelEmit< float   >( out, records );
+            else                                                                 return channelEmit< int32_t >( out, records );
+          },
+          "Append records to a channel drained natively by the embedding caller. records is anything numpy "
+          "can convert to the channel type, flattened into whole records. Returns the number of records "
+          "accepted, the remainder are dropped if this thread's buffer is full",
+          pybind11::arg( "channel" ),
+          pybind11::arg( "records" )
+          );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Provides python-side helpers for the arrays of an embedded module,
+///        done once per module upon first embedPtr
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter::embedArrayHelpers(
+                                        std::string pymodule ///< Python module to operate on
+                                        )
+{
+  if ( arrayHelpersEmbedded_.count( pymodule ) )
+  {
+    return;
+  }
+  checkHelperNames( pymodule, arrayHelperNames, sizeof( arrayHelperNames ) / sizeof( arrayHelperNames[0] ) );
+  arrayHelpersEmbedded_.insert( pymodule );
+
+  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+
+  // pymodule.version( "attr" )
+  mod.def(
+          "version",
+          [=]( std::string attr )
+          {
+            return arrayVersion( pymodule, attr );
+          },
+          "Version of an embedded array, bumped each time the embedding caller marks it dirty"
+          );
+
+  // pymodule.dirty( "attr" ) -> ( version, begin, end )
+  mod.def(
+          "dirty",
+          [=]( std::string attr )
+          {
+            std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+            const EmbeddedArray &array = findEmbeddedArray( pymodule, attr );
+            return pybind11::make_tuple( array.version, array.dirtyBegin, array.dirtyEnd );
+          },
+          "( version, begin, end ) of an embedded array, flat [begin, end) elements marked dirty since last clean()"
+          );
+
+  // pymodule.clean( "attr" )
+  mod.def(
+          "clean",
+          [=]( std::string attr )
+          {
+            std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+            EmbeddedArray &array = findEmbeddedArray( pymodule, attr );
+            array.dirtyBegin = 0;
+            array.dirtyEnd   = 0;
+          },
+          "Reset the dirty region of an embedded array, version is retained"
+          );
+
+  // pymodule.memoize( "attr", func, key=None )
+  mod.def(
+          "memoize",
+          [=]( std::string attr, pybind11::function func, pybind11::object key )
+          {
+            uint64_t          version = arrayVersion( pymodule, attr );
+            pybind11::module_ self    = pymodulesEmbedded_[ pymodule ];
+
+            if ( !pybind11::hasattr( self, "__pyio_memo__" ) )
+            {
+              self.attr( "__pyio_memo__" ) = pybind11::dict();
+            }
+
+            // Results of attr from older versions can never hit again, so each
+            // attr holds ( version, results ) and results restart on a new version
+            pybind11::dict memo = self.attr( "__pyio_memo__" ).cast< pybind11::dict >();
+            if ( !memo.contains( attr.c_str() ) || memo[ attr.c_str() ].cast< pybind11::tuple >()[0].cast< uint64_t >() != version )
+            {
+              memo[ attr.c_str() ] = pybind11::make_tuple( version, pybind11::dict() );
+            }
+            pybind11::dict results = memo[ attr.c_str() ].cast< pybind11::tuple >()[1].cast< pybind11::dict >();
+
+            // Keyed on the callable itself, the key holds a strong reference so
+            // its identity cannot be reused by another object while cached
+            pybind11::object cacheKey = key.is_none() ? pybind11::object( func ) : key;
+            if ( results.contains( cacheKey ) )
+            {
+              return pybind11::object( results[ cacheKey ] );
+            }
+
+            pybind11::object result = func( self.attr( attr.c_str() )() );
+            results[ cacheKey ] = result;
+            return result;
+          },
+          "Result of func( pymodule.attr() ), only recomputed when the array version changes. "
+          "Results are cached per ( attr, func ) on the identity of func, so pass the same "
+          "callable each time rather than a new lambda. key overrides func as the cache key, "
+          "e.g. for a lambda rebuilt on every call",
+          pybind11::arg( "attr" ),
+          pybind11::arg( "func" ),
+          pybind11::arg( "key" ) = pybind11::none()
+          );
+
+  // pymodule.reduced( "attr", type="float32" )
+  mod.def(
+          "reduced",
+          [=]( std::string attr, std::string type )
+          {
+            return reducedArray( pymodule, attr, type );
+          },
+          "Read-only copy of an embedded array as float32, float16, uint16, or uint8, only reconverted "
+          "when the array version changes, or on every call if it was never marked dirty. Quantized types return ( array, offset, scale ) with values "
+          "recovered as offset + array * scale",
+          pybind11::arg( "attr" ),
+          pybind11::arg( "type" ) = "float32"
+          );
+
+  // pymodule.stats( "attr" ) -> dict
+  mod.def(
+          "stats",
+          [=]( std::string attr )
+          {
+            return arrayStats( pymodule, attr );
+          },
+          "Summary of an embedded array computed natively in parallel without the GIL: count, nan, inf, "
+          "min, max, sum, mean, var, std. NaN and inf are counted and excluded from everything else"
+          );
+
+  // pymodule.histogram( "attr", bins=10, range=None ) -> ( counts, edges, nan )
+  mod.def(
+          "histogram",
+          [=]( std::string attr, size_t bins, pybind11::object range )
+          {
+            return arrayHistogram( pymodule, attr, bins, range );
+          },
+          "( counts, edges, nan ) of an embedded array, counts and edges as numpy.histogram, computed natively "
+          "in parallel without the GIL. NaN and inf are excluded from counts, nan is the number of NaN values "
+          "dropped. range is any ( lo, hi ) sequence, defaulting to the finite ( min, max )",
+          pybind11::arg( "attr" ),
+          pybind11::arg( "bins" )  = 10,
+          pybind11::arg( "range" ) = pybind11::none()
+          );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Provides a reduced precision copy of an embedded array, converted with
+///        native parallel kernels into a pooled buffer
+///
+/// The buffer is reused across versions unless a previously returned numpy array
+/// still references it, in which case a new one is drawn so earlier results are
+/// left intact. Arrays never marked dirty ( version 0 ) may change without notice
+/// and are reconverted on every call. A buffer being converted is taken out of
+/// the pool, so concurrent callers never write the same buffer
+////////////////////////////////////////////////////////////////////////////////
+pybind11::object
+EmbeddedInterpreter::reducedArray(
+                                  std::string pymodule, ///< Python module the array was embedded in
+                                  std::string attr,     ///< python attribute of the array
+                                  std::string type      ///< numpy dtype name to reduce to
+                                  )
+{
+  int reduced = ArrayKernels::reducedType( type );
+  if ( reduced < 0 )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Unsupported reduced type '" << type << "'" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  EmbeddedArray source;
+  {
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    source = findEmbeddedArray( pymodule, attr );
+  }
+
+  size_t                                 itemSize = ArrayKernels::reducedItemSize( reduced );
+  size_t                                 numBytes = source.numElements() * itemSize;
+  std::shared_ptr< std::vector< char > > buffer;
+  double                                 offset   = 0.0;
+  double                                 scale    = 1.0;
+  bool                                   stale    = true;
+  {
+    std::lock_guard< std::mutex > lock( reducedArraysMutex_ );
+    ReducedArray &cached = reducedArrays_[ pymodule + "." + attr + ":" + type ];
+    if ( cached.buffer && source.version > 0 && cached.version == source.version )
+    {
+      buffer = cached.buffer;
+      offset = cached.offset;
+      scale  = cached.scale;
+      stale  = false;
+    }
+    else if ( cached.buffer && cached.buffer.use_count() == 1 && cached.buffer->size() == numBytes )
+    {
+      buffer.swap( cached.buffer );
+    }
+  }
+
+  if ( stale )
+  {
+    if ( !buffer )
+    {
+      buffer = std::make_shared< std::vector< char > >( numBytes );
+    }
+
+    FPE_GUARD_START( fpeTemp );
+    {
+      pybind11::gil_scoped_release release;
+      ArrayKernels::reduce( source, reduced, buffer->data(), offset, scale );
+    }
+    FPE_GUARD_STOP( fpeTemp );
+
+    std::lock_guard< std::mutex > lock( reducedArraysMutex_ );
+    ReducedArray &cached = reducedArrays_[ pymodule + "." + attr + ":" + type ];
+    cached.buffer  = buffer;
+    cached.version = source.version;
+    cached.offset  = offset;
+    cached.scale   = scale;
+  }
+
+  // Same layout as the source, just narrower elements
+  std::vector< ssize_t > shape( source.dims.begin(), source.dims.end() );
+  std::vector< ssize_t > strides( shape.size() );
+  ssize_t                stride = itemSize;
+  for ( size_t i = 0; i < shape.size(); i++ )
+  {
+    size_t dim = source.fortranOrder ? i : shape.size() - 1 - i;
+    strides[ dim ] = stride;
+    stride        *= shape[ dim ];
+  }
+
+  // numpy array keeps its buffer alive
+  pybind11::capsule owner(
+                          new std::shared_ptr< std::vector< char > >( buffer ),
+                          []( void *pBuffer )
+                          {
+                            delete static_cast< std::shared_ptr< std::vector< char > > * >( pBuffer );
+                          }
+                          );
+  pybind11::array view( pybind11::dtype::from_args( pybind11::str( type ) ), shape, strides, buffer->data(), owner );
+  view.attr( "setflags" )( pybind11::arg( "write" ) = false );
+
+  if ( ArrayKernels::reducedQuantized( reduced ) )
+  {
+    return pybind11::make_tuple( view, offset, scale );
+  }
+  return view;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Summary of an embedded array as a python dict, computed with native
+///        parallel kernels on every call
+////////////////////////////////////////////////////////////////////////////////
+pybind11::object
+EmbeddedInterpreter::arrayStats(
+                                std::string pymodule, ///< Python module the array was embedded in
+                                std::string attr      ///< python attribute of the array
+                                )
+{
+  EmbeddedArray source;
   {
-    pymodules_[ pymodule ].attr( function.c_str() )();
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    source = findEmbeddedArray( pymodule, attr );
   }
-  else
+
+  // Always recomputed, python may write the array without the version changing
+  ArrayKernels::Stats stats;
+  FPE_GUARD_START( fpeTemp );
   {
-    std::cout << "Warning: Python module '"      << pymodule 
-              << "' does not contain function '" << function 
-              << "', not executed." << std::endl;
+    pybind11::gil_scoped_release release;
+    ArrayKernels::stats( source, stats );
   }
   FPE_GUARD_STOP( fpeTemp );
-}
 
+  pybind11::dict result;
+  result[ "count" ] = stats.count;
+  result[ "nan" ]   = stats.numNaN;
+  result[ "inf" ]   = stats.numInf;
+  result[ "min" ]   = stats.min;
+  result[ "max" ]   = stats.max;
+  result[ "sum" ]   = stats.sum;
+  result[ "mean" ]  = stats.mean;
+  result[ "var" ]   = stats.variance;
+  result[ "std" ]   = std::sqrt( stats.variance );
+  return result;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \brief Checks if the embedded python module has been loaded and reports findings
-///        if necessary or simply loads
+/// \brief Histogram of an embedded array as ( counts, edges ) numpy arrays and
+///        the number of NaN values dropped, binned with native parallel kernels
 ////////////////////////////////////////////////////////////////////////////////
-bool
-EmbeddedInterpreter::checkEmbeddedModuleLoaded(
-                                                std::string pymodule ///< Python module to operate on
-                                                )
+pybind11::object
+EmbeddedInterpreter::arrayHistogram(
+                                    std::string      pymodule, ///< Python module the array was embedded in
+                                    std::string      attr,     ///< python attribute of the array
+                                    size_t           bins,     ///< number of equal width bins
+                                    pybind11::object range     ///< ( lo, hi ) or None for the finite ( min, max )
+                                    )
 {
-  if ( pymodulesEmbedded_.find( pymodule ) == pymodulesEmbedded_.end() )
+  if ( bins == 0 )
   {
-    if ( autoLoad_ )
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: histogram of '" << pymodule << "." << attr << "' requires at least one bin" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  EmbeddedArray source;
+  {
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    source = findEmbeddedArray( pymodule, attr );
+  }
+
+  double lo, hi;
+  if ( range.is_none() )
+  {
+    size_t numFinite;
+    FPE_GUARD_START( fpeTemp );
     {
-      embeddedPymoduleLoad( pymodule );
+      pybind11::gil_scoped_release release;
+      ArrayKernels::finiteMinMax( source, lo, hi, numFinite );
     }
-    else
+    FPE_GUARD_STOP( fpeTemp );
+    lo = numFinite > 0 ? lo : 0.0;
+    hi = numFinite > 0 ? hi : 1.0;
+  }
+  else
+  {
+    // Any ( lo, hi ) sequence, as numpy accepts lists too
+    pybind11::sequence bounds = range.cast< pybind11::sequence >();
+    if ( bounds.size() != 2 )
     {
       std::stringstream ss;
-      ss << __FILE__ << ":" << __LINE__ << " : Error: Module '" << pymodule << "' has not beed loaded" << std::endl;
+      ss << __FILE__ << ":" << __LINE__ << " : Error: histogram range of '" << pymodule << "." << attr << "' must be ( lo, hi )" << std::endl;
       std::cerr << ss.str();
       throw std::runtime_error( ss.str() );
     }
+    lo = bounds[0].cast< double >();
+    hi = bounds[1].cast< double >();
   }
-  return true;
+  if ( !( lo <= hi ) || !std::isfinite( lo ) || !std::isfinite( hi ) )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: histogram of '" << pymodule << "." << attr << "' requires a finite range lo <= hi" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+  if ( lo == hi )
+  {
+    // Same widening as numpy for a constant array
+    lo -= 0.5;
+    hi += 0.5;
+  }
+
+  std::vector< int64_t > counts( bins );
+  size_t                 numNaN = 0;
+  FPE_GUARD_START( fpeTemp );
+  {
+    pybind11::gil_scoped_release release;
+    numNaN = ArrayKernels::histogram( source, lo, hi, counts );
+  }
+  FPE_GUARD_STOP( fpeTemp );
+
+  std::vector< double > edges( bins + 1 );
+  for ( size_t i = 0; i <= bins; i++ )
+  {
+    edges[i] = lo + ( hi - lo ) * i / bins;
+  }
+
+  return pybind11::make_tuple(
+                              pybind11::array_t< int64_t >( static_cast< ssize_t >( bins ), counts.data() ),
+                              pybind11::array_t< double  >( static_cast< ssize_t >( bins + 1 ), edges.data() ),
+                              numNaN
+                              );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -372,6 +1652,78 @@ EmbeddedInterpreter_pymoduleCall( EmbeddedInterpreter *pObj, char *pymodule, cha
   pObj->pymoduleCall( std::string( pymodule ), std::string( function ) );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for memoryTracking
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_memoryTracking( EmbeddedInterpreter *pObj, bool enable )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->memoryTracking( enable );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for memoryBudget
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_memoryBudget( EmbeddedInterpreter *pObj, char *pymodule, char *function, size_t bytes, int action )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->memoryBudget( std::string( pymodule ), std::string( function ), bytes, action );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for profilerStart
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_profilerStart( EmbeddedInterpreter *pObj, double hz, char *prefix )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->profilerStart( hz, std::string( prefix ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for profilerStop
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_profilerStop( EmbeddedInterpreter *pObj )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->profilerStop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for recordStart
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_recordStart( EmbeddedInterpreter *pObj, char *filename, size_t numCalls )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->recordStart( std::string( filename ), numCalls );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for recordStop
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_recordStop( EmbeddedInterpreter *pObj )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->recordStop();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief C binding for embeddedPymoduleLoad
 ////////////////////////////////////////////////////////////////////////////////
@@ -607,3 +1959,214 @@ EmbeddedInterpreter_embedInt32ValueCase( EmbeddedInterpreter *pObj, char *pymodu
   pObj->embedValueCase( std::string( pymodule ), std::string( attr ), std::string( attrCase ), func );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//##############################################################################
+///// Native array output
+//##############################################################################
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for arrayDump
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_arrayDump( EmbeddedInterpreter *pObj, char *pymodule, char *attr, char *filename, int mode )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->arrayDump( std::string( pymodule ), std::string( attr ), std::string( filename ), mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for arrayDumpModule
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_arrayDumpModule( EmbeddedInterpreter *pObj, char *pymodule, char *directory, int mode )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->arrayDumpModule( std::string( pymodule ), std::string( directory ), mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for arrayDumpContainer, always writes all arrays of pymodule
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_arrayDumpContainer( EmbeddedInterpreter *pObj, char *pymodule, char *filename, int mode )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->arrayDumpContainer( std::string( pymodule ), std::vector< std::string >(), std::string( filename ), mode );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for arrayDumpWait
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_arrayDumpWait( EmbeddedInterpreter *pObj )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->arrayDumpWait();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//##############################################################################
+///// Change tracking
+//##############################################################################
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for markDirty
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_markDirty( EmbeddedInterpreter *pObj, char *pymodule, char *attr )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->markDirty( std::string( pymodule ), std::string( attr ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for markDirtyRange, first and last are 1-based inclusive
+///        flat indices as natural from Fortran
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_markDirtyRange( EmbeddedInterpreter *pObj, char *pymodule, char *attr, size_t first, size_t last )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  if ( first < 1 || first > last )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Invalid dirty range [" << first << ", " << last << "] of '" << pymodule << "." << attr << "', requires 1 <= first <= last" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+  pObj->markDirtyRange( std::string( pymodule ), std::string( attr ), first - 1, last );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//##############################################################################
+///// Value caching
+//##############################################################################
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for valueCache
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_valueCache( EmbeddedInterpreter *pObj, char *pymodule, char *attr, int policy )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->valueCache( std::string( pymodule ), std::string( attr ), policy );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for advanceEpoch
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_advanceEpoch( EmbeddedInterpreter *pObj )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->advanceEpoch();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//##############################################################################
+///// Output channels
+//##############################################################################
+////////////////////////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelCreate< double >
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelCreateDouble( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t recordLength, size_t capacity )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->channelCreate< double >( std::string( pymodule ), std::string( channel ), recordLength, capacity );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelCreate< float >
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelCreateFloat( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t recordLength, size_t capacity )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->channelCreate< float >( std::string( pymodule ), std::string( channel ), recordLength, capacity );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelCreate< int32_t >
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelCreateInt32( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t recordLength, size_t capacity )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  pObj->channelCreate< int32_t >( std::string( pymodule ), std::string( channel ), recordLength, capacity );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelDrain< double >
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelDrainDouble( EmbeddedInterpreter *pObj, char *pymodule, char *channel, double *buffer, size_t maxRecords, size_t *pNumRecords )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  (*pNumRecords) = pObj->channelDrain( std::string( pymodule ), std::string( channel ), buffer, maxRecords );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelDrain< float >
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelDrainFloat( EmbeddedInterpreter *pObj, char *pymodule, char *channel, float *buffer, size_t maxRecords, size_t *pNumRecords )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  (*pNumRecords) = pObj->channelDrain( std::string( pymodule ), std::string( channel ), buffer, maxRecords );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelDrain< int32_t >
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelDrainInt32( EmbeddedInterpreter *pObj, char *pymodule, char *channel, int32_t *buffer, size_t maxRecords, size_t *pNumRecords )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  (*pNumRecords) = pObj->channelDrain( std::string( pymodule ), std::string( channel ), buffer, maxRecords );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief C binding for channelPending
+////////////////////////////////////////////////////////////////////////////////
+void
+EmbeddedInterpreter_channelPending( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t *pNumRecords )
+{
+#ifndef NDEBUG
+  std::cout << __func__ << ": " <<  static_cast< void * >( pObj ) << std::endl;
+#endif
+  (*pNumRecords) = pObj->channelPending( std::string( pymodule ), std::string( channel ) );
+}
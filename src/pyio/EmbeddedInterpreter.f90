@@ -4,6 +4,20 @@ module EmbeddedInterpreter
   implicit none
   type( c_ptr ), public :: eimod_pEmbeddedInterpreter = c_null_ptr
 
+  ! Modes for EmbeddedInterpreter_arrayDump*, match ArrayWriter::Mode
+  integer( c_int ), parameter, public :: EI_DUMP_SYNC           = 0
+  integer( c_int ), parameter, public :: EI_DUMP_ASYNC          = 1
+  integer( c_int ), parameter, public :: EI_DUMP_ASYNC_SNAPSHOT = 2
+
+  ! Actions for EmbeddedInterpreter_memoryBudget, match EmbeddedInterpreter::BudgetAction
+  integer( c_int ), parameter, public :: EI_BUDGET_LOG          = 0
+  integer( c_int ), parameter, public :: EI_BUDGET_FAIL         = 1
+
+  ! Policies for EmbeddedInterpreter_valueCache, match EmbeddedInterpreter::CachePolicy
+  integer( c_int ), parameter, public :: EI_CACHE_ALWAYS        = 0
+  integer( c_int ), parameter, public :: EI_CACHE_ONCE          = 1
+  integer( c_int ), parameter, public :: EI_CACHE_EPOCH         = 2
+
   interface
     
     subroutine EmbeddedInterpreter_ctor              ( eiPtr )              &
@@ -109,6 +123,70 @@ module EmbeddedInterpreter
       ! return void
     end subroutine EmbeddedInterpreter_pymoduleCall
 
+    subroutine EmbeddedInterpreter_memoryTracking    ( eiPtr, enable )   &
+      bind( c, name="EmbeddedInterpreter_memoryTracking"     )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      logical( c_bool ), value, intent( in ) :: enable
+      ! return void
+    end subroutine EmbeddedInterpreter_memoryTracking
+
+    subroutine EmbeddedInterpreter_memoryBudget      ( eiPtr, pymodule, func, bytes, action )   &
+      bind( c, name="EmbeddedInterpreter_memoryBudget"       )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      ! empty pymodule or func apply the budget to all
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: func
+      integer( c_size_t ), value, intent( in ) :: bytes
+      integer( c_int ),    value, intent( in ) :: action
+      ! return void
+    end subroutine EmbeddedInterpreter_memoryBudget
+
+    subroutine EmbeddedInterpreter_profilerStart     ( eiPtr, hz, prefix )   &
+      bind( c, name="EmbeddedInterpreter_profilerStart"      )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      real( c_double ), value, intent( in ) :: hz
+      character( kind = c_char ), dimension(*), intent( in ) :: prefix
+      ! return void
+    end subroutine EmbeddedInterpreter_profilerStart
+
+    subroutine EmbeddedInterpreter_profilerStop      ( eiPtr )   &
+      bind( c, name="EmbeddedInterpreter_profilerStop"       )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      ! return void
+    end subroutine EmbeddedInterpreter_profilerStop
+
+    subroutine EmbeddedInterpreter_recordStart      ( eiPtr, filename, numCalls )   &
+      bind( c, name="EmbeddedInterpreter_recordStart"       )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: filename
+      integer( c_size_t ), value, intent( in ) :: numCalls
+      ! return void
+    end subroutine EmbeddedInterpreter_recordStart
+
+    subroutine EmbeddedInterpreter_recordStop       ( eiPtr )   &
+      bind( c, name="EmbeddedInterpreter_recordStop"        )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      ! return void
+    end subroutine EmbeddedInterpreter_recordStop
+
     subroutine EmbeddedInterpreter_embeddedPymoduleLoad      ( eiPtr, pymodule )   &
       bind( c, name="EmbeddedInterpreter_embeddedPymoduleLoad"       )
       ! get iso_c_binding types
@@ -333,6 +411,211 @@ module EmbeddedInterpreter
       ! return void
     end subroutine EmbeddedInterpreter_embedInt32ValueCase
 
+    !////////////////////////////////////////////////////////////////////////////
+    !//##########################################################################
+    !///// Value caching
+    !//##########################################################################
+    !////////////////////////////////////////////////////////////////////////////
+    subroutine EmbeddedInterpreter_valueCache        ( eiPtr, pymodule, attr, policy ) &
+      bind( c, name="EmbeddedInterpreter_valueCache"         )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: attr
+      integer( c_int ), value, intent( in ) :: policy
+      ! return void
+    end subroutine EmbeddedInterpreter_valueCache
+
+    subroutine EmbeddedInterpreter_advanceEpoch      ( eiPtr ) &
+      bind( c, name="EmbeddedInterpreter_advanceEpoch"       )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      ! return void
+    end subroutine EmbeddedInterpreter_advanceEpoch
+
+    !////////////////////////////////////////////////////////////////////////////
+    !//##########################################################################
+    !///// Output channels
+    !//##########################################################################
+    !////////////////////////////////////////////////////////////////////////////
+    subroutine EmbeddedInterpreter_channelCreateDouble( eiPtr, pymodule, channel, recordLength, capacity ) &
+      bind( c, name="EmbeddedInterpreter_channelCreateDouble" )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      integer( c_size_t ), value, intent( in ) :: recordLength
+      integer( c_size_t ), value, intent( in ) :: capacity
+      ! return void
+    end subroutine EmbeddedInterpreter_channelCreateDouble
+
+    subroutine EmbeddedInterpreter_channelCreateFloat ( eiPtr, pymodule, channel, recordLength, capacity ) &
+      bind( c, name="EmbeddedInterpreter_channelCreateFloat"  )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      integer( c_size_t ), value, intent( in ) :: recordLength
+      integer( c_size_t ), value, intent( in ) :: capacity
+      ! return void
+    end subroutine EmbeddedInterpreter_channelCreateFloat
+
+    subroutine EmbeddedInterpreter_channelCreateInt32 ( eiPtr, pymodule, channel, recordLength, capacity ) &
+      bind( c, name="EmbeddedInterpreter_channelCreateInt32"  )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      integer( c_size_t ), value, intent( in ) :: recordLength
+      integer( c_size_t ), value, intent( in ) :: capacity
+      ! return void
+    end subroutine EmbeddedInterpreter_channelCreateInt32
+
+    subroutine EmbeddedInterpreter_channelDrainDouble ( eiPtr, pymodule, channel, buffer, maxRecords, numRecords ) &
+      bind( c, name="EmbeddedInterpreter_channelDrainDouble"  )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      real( c_double ),     dimension(*), intent( out ) :: buffer
+      integer( c_size_t ),  value,        intent( in  ) :: maxRecords
+      integer( c_size_t ),                intent( out ) :: numRecords
+      ! return void
+    end subroutine EmbeddedInterpreter_channelDrainDouble
+
+    subroutine EmbeddedInterpreter_channelDrainFloat  ( eiPtr, pymodule, channel, buffer, maxRecords, numRecords ) &
+      bind( c, name="EmbeddedInterpreter_channelDrainFloat"   )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      real( c_float ),      dimension(*), intent( out ) :: buffer
+      integer( c_size_t ),  value,        intent( in  ) :: maxRecords
+      integer( c_size_t ),                intent( out ) :: numRecords
+      ! return void
+    end subroutine EmbeddedInterpreter_channelDrainFloat
+
+    subroutine EmbeddedInterpreter_channelDrainInt32  ( eiPtr, pymodule, channel, buffer, maxRecords, numRecords ) &
+      bind( c, name="EmbeddedInterpreter_channelDrainInt32"   )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      integer( c_int32_t ), dimension(*), intent( out ) :: buffer
+      integer( c_size_t ),  value,        intent( in  ) :: maxRecords
+      integer( c_size_t ),                intent( out ) :: numRecords
+      ! return void
+    end subroutine EmbeddedInterpreter_channelDrainInt32
+
+    subroutine EmbeddedInterpreter_channelPending      ( eiPtr, pymodule, channel, numRecords ) &
+      bind( c, name="EmbeddedInterpreter_channelPending"       )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: channel
+      integer( c_size_t ), intent( out ) :: numRecords
+      ! return void
+    end subroutine EmbeddedInterpreter_channelPending
+
+    !////////////////////////////////////////////////////////////////////////////
+    !//##########################################################################
+    !///// Native array output
+    !//##########################################################################
+    !////////////////////////////////////////////////////////////////////////////
+    subroutine EmbeddedInterpreter_arrayDump         ( eiPtr, pymodule, attr, filename, mode ) &
+      bind( c, name="EmbeddedInterpreter_arrayDump"          )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: attr
+      character( kind = c_char ), dimension(*), intent( in ) :: filename
+      integer( c_int ), value, intent( in ) :: mode
+      ! return void
+    end subroutine EmbeddedInterpreter_arrayDump
+
+    subroutine EmbeddedInterpreter_arrayDumpModule   ( eiPtr, pymodule, directory, mode ) &
+      bind( c, name="EmbeddedInterpreter_arrayDumpModule"    )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: directory
+      integer( c_int ), value, intent( in ) :: mode
+      ! return void
+    end subroutine EmbeddedInterpreter_arrayDumpModule
+
+    subroutine EmbeddedInterpreter_arrayDumpContainer( eiPtr, pymodule, filename, mode ) &
+      bind( c, name="EmbeddedInterpreter_arrayDumpContainer" )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: filename
+      integer( c_int ), value, intent( in ) :: mode
+      ! return void
+    end subroutine EmbeddedInterpreter_arrayDumpContainer
+
+    subroutine EmbeddedInterpreter_arrayDumpWait     ( eiPtr ) &
+      bind( c, name="EmbeddedInterpreter_arrayDumpWait"      )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      ! return void
+    end subroutine EmbeddedInterpreter_arrayDumpWait
+
+    !////////////////////////////////////////////////////////////////////////////
+    !//##########################################################################
+    !///// Change tracking
+    !//##########################################################################
+    !////////////////////////////////////////////////////////////////////////////
+    subroutine EmbeddedInterpreter_markDirty         ( eiPtr, pymodule, attr ) &
+      bind( c, name="EmbeddedInterpreter_markDirty"          )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: attr
+      ! return void
+    end subroutine EmbeddedInterpreter_markDirty
+
+    subroutine EmbeddedInterpreter_markDirtyRange    ( eiPtr, pymodule, attr, first, last ) &
+      bind( c, name="EmbeddedInterpreter_markDirtyRange"     )
+      ! get iso_c_binding types
+      import
+      implicit none
+      type( c_ptr ), value :: eiPtr
+      character( kind = c_char ), dimension(*), intent( in ) :: pymodule
+      character( kind = c_char ), dimension(*), intent( in ) :: attr
+      ! 1-based inclusive flat indices into the array, in memory order
+      integer( c_size_t ), value, intent( in ) :: first
+      integer( c_size_t ), value, intent( in ) :: last
+      ! return void
+    end subroutine EmbeddedInterpreter_markDirtyRange
+
   end interface
 
   interface EmbeddedInterpreter_embedPtr
@@ -2,11 +2,16 @@
 #ifndef EmbeddedInterpreter_hpp
 #define EmbeddedInterpreter_hpp
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <set>
 
 #include <fenv.h>
 
@@ -14,6 +19,12 @@
 #include "pybind11/embed.h"
 #include "pybind11/numpy.h"
 
+#include "ArrayKernels.hpp"
+#include "ArrayWriter.hpp"
+#include "EmbeddedArray.hpp"
+#include "OutputChannel.hpp"
+#include "SamplingProfiler.hpp"
+#include "Trace.hpp"
 
 // https://github.com/numpy/numpy/issues/20504
 #define  FPE_GUARD_START( stash ) fenv_t stash; feholdexcept( &stash )
@@ -23,6 +34,19 @@
 class EmbeddedInterpreter
 {
 public:
+  enum BudgetAction
+  {
+    BUDGET_LOG  = 0, ///< Report pymoduleCall invocations exceeding their memory budget
+    BUDGET_FAIL = 1  ///< Throw once a pymoduleCall invocation returns having exceeded its memory budget
+  };
+
+  enum CachePolicy
+  {
+    CACHE_ALWAYS = 0, ///< Evaluate on every python read, the default
+    CACHE_ONCE   = 1, ///< Evaluate on first python read only
+    CACHE_EPOCH  = 2  ///< Evaluate on first python read after each advanceEpoch
+  };
+
   // Ctor Dtor
   EmbeddedInterpreter();
   virtual ~EmbeddedInterpreter();
@@ -41,7 +65,20 @@ public:
   void pymoduleLoad      ( std::string pymodule );
   void pymoduleCall      ( std::string pymodule, std::string function );
 
-  // Embedded module loading
+  // Accounting of pymoduleCall, reported at finalize - empty pymodule / function act as wildcards for budgets
+  // tracemalloc is process wide, so memory is only accounted for calls that do not overlap another pymoduleCall
+  void memoryTracking( bool enable );
+  void memoryBudget  ( std::string pymodule, std::string function, size_t bytes, int action );
+
+  // Sampling of python stacks within pymoduleCall, written to <prefix>.<rank>.folded at finalize
+  void profilerStart( double hz, std::string prefix );
+  void profilerStop ();
+
+  // Record embedded data, values, and calls to a trace replayable offline with pyio_replay
+  void recordStart( std::string filename, size_t numCalls );
+  void recordStop ();
+
+  // Embedded module loading, modules not compiled in are created at runtime - attributes are defined on first python access
   void embeddedPymoduleLoad( std::string pymodule );
 
   // Building python-accesible modules - only operable on pymodules loaded from embedPymoduleLoad
@@ -54,8 +91,115 @@ public:
   template< typename T >
   void embedValueCase( std::string pymodule, std::string attr, std::string attrCase, T (*func)(const char*) );
 
+  // Caching of values from embedValueFunc / embedValueCase, hits and misses reported at finalize
+  void valueCache  ( std::string pymodule, std::string attr, int policy );
+  void advanceEpoch();
+
+  // Typed record channels from python back to the embedding caller, appended to via pymodule.emit( "channel", records )
+  template< typename T >
+  void   channelCreate ( std::string pymodule, std::string channel, size_t recordLength, size_t capacity );
+  template< typename T >
+  size_t channelDrain  ( std::string pymodule, std::string channel, T *buffer, size_t maxRecords );
+  size_t channelPending( std::string pymodule, std::string channel );
+
+  // Native output of arrays registered with embedPtr - mode is an ArrayWriter::Mode
+  void arrayDump         ( std::string pymodule, std::string attr, std::string filename, int mode );
+  void arrayDumpModule   ( std::string pymodule, std::string directory, int mode );
+  void arrayDumpContainer( std::string pymodule, std::vector< std::string > attrs, std::string filename, int mode );
+  void arrayDumpWait     ();
+
+  // Change tracking of arrays registered with embedPtr, ranges are flat [begin, end) element indices
+  void     markDirty     ( std::string pymodule, std::string attr );
+  void     markDirtyRange( std::string pymodule, std::string attr, size_t begin, size_t end );
+  uint64_t arrayVersion  ( std::string pymodule, std::string attr );
+
 private:
   bool checkEmbeddedModuleLoaded( std::string pymodule );
+  void checkAttrName( std::string pymodule, std::string attr );
+  void checkHelperNames( std::string pymodule, const char *const *names, size_t numNames );
+  pybind11::module_ createEmbeddedModule( std::string pymodule );
+  void embedLazyAttributes( std::string pymodule );
+  void defineAttr( std::string pymodule, std::string attr, std::function< void( pybind11::module_ & ) > define );
+  EmbeddedArray &findEmbeddedArray( std::string pymodule, std::string attr );
+  void embedArrayHelpers( std::string pymodule );
+  pybind11::object reducedArray( std::string pymodule, std::string attr, std::string type );
+  pybind11::object arrayStats    ( std::string pymodule, std::string attr );
+  pybind11::object arrayHistogram( std::string pymodule, std::string attr, size_t bins, pybind11::object range );
+  void recordCallTime( const std::string &key, std::chrono::steady_clock::time_point start, bool failed );
+  void trackedCallExit();
+  void reportCallStats();
+
+  template< typename T >
+  T recordValue( const std::string &pymodule, const std::string &attr, T val );
+  void reportValueCaches();
+
+  OutputChannel &findChannel( std::string pymodule, std::string channel );
+  void embedChannelHelpers( std::string pymodule );
+  template< typename T >
+  size_t channelEmit( OutputChannel &channel, pybind11::object records );
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Cache state of a value from embedValueFunc / embedValueCase, only
+  ///        touched while holding the GIL
+  ////////////////////////////////////////////////////////////////////////////////
+  struct ValueCache
+  {
+    ValueCache() : policy( CACHE_ALWAYS ), epoch( 0 ), valid( false ), hits( 0 ), misses( 0 ) {}
+    virtual ~ValueCache() {}
+
+    int      policy; ///< EmbeddedInterpreter::CachePolicy
+    uint64_t epoch;  ///< epoch the value was evaluated in
+    bool     valid;  ///< value has been evaluated under the current policy
+    size_t   hits;   ///< python reads served from the cache
+    size_t   misses; ///< python reads that called back into the embedding caller
+  };
+
+  template< typename T >
+  struct CachedValue : public ValueCache
+  {
+    T value; ///< last evaluated value
+  };
+
+  template< typename T >
+  std::shared_ptr< CachedValue< T > > makeValueCache( const std::string &pymodule, const std::string &attr );
+
+  template< typename T, typename F >
+  T cachedValue( CachedValue< T > &cache, const F &evaluate );
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Pooled reduced precision copy of an embedded array
+  ////////////////////////////////////////////////////////////////////////////////
+  struct ReducedArray
+  {
+    std::shared_ptr< std::vector< char > > buffer;  ///< conversion output, shared with numpy arrays handed out
+    uint64_t                               version; ///< source version the buffer was converted from
+    double                                 offset;  ///< quantization offset
+    double                                 scale;   ///< quantization scale
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Accumulated accounting of a python function invoked via pymoduleCall
+  ////////////////////////////////////////////////////////////////////////////////
+  struct CallStats
+  {
+    size_t    calls;         ///< number of invocations, including failed ones
+    size_t    failures;      ///< invocations that raised
+    double    seconds;       ///< total wall time
+    double    maxSeconds;    ///< slowest single invocation
+    size_t    memoryCalls;   ///< invocations with memory accounted, those that completed without overlapping another pymoduleCall
+    size_t    peakBytes;     ///< largest python allocation peak of a single accounted invocation, above its starting traced size
+    long long retainedBytes; ///< net python allocation left behind, summed over accounted invocations
+    size_t    overBudget;    ///< invocations that exceeded their memory budget
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Limit on python allocation peak of a single pymoduleCall
+  ////////////////////////////////////////////////////////////////////////////////
+  struct MemoryBudget
+  {
+    size_t bytes;  ///< peak bytes allowed above the starting traced size
+    int    action; ///< EmbeddedInterpreter::BudgetAction when exceeded
+  };
 
   
   pybind11::scoped_interpreter        guard_;            ///< Directly maintain the lifetime of this guard within this scope
@@ -63,13 +207,48 @@ private:
   std::unordered_map< std::string, pybind11::module_ >   pymodules_;         ///< Map of pymodules loaded ready to be called
   std::unordered_map< std::string, pybind11::module_ >   pymodulesEmbedded_; ///< Map of embedded pymodules available to python
 
+  std::map< std::string, std::map< std::string, EmbeddedArray > > embeddedArrays_;       ///< Native description of arrays from embedPtr, per pymodule then attr
+  std::mutex                                                      embeddedArraysMutex_;  ///< Guards change tracking state within embeddedArrays_
+  std::set< std::string >                                         arrayHelpersEmbedded_; ///< pymodules already provided python-side array helpers
+  ArrayWriter                                                     arrayWriter_;          ///< Native .npy / container output of embeddedArrays_
+  std::map< std::string, ReducedArray >                           reducedArrays_;        ///< Reduced copies of embeddedArrays_, per "pymodule.attr:type"
+  std::mutex                                                      reducedArraysMutex_;   ///< Guards reducedArrays_, conversion runs without the GIL
+
   // OpenMP shenanigans
   std::vector< PyGILState_STATE > gilStates_;        ///< retain gil states per thread to transform POSIX original threads to "python threads"
   PyThreadState                  *pMainThreadState_; ///< retain main thread state
 
+  // Call accounting
+  std::map< std::string, CallStats >    callStats_;      ///< Accounting per "pymodule:function"
+  std::map< std::string, MemoryBudget > memoryBudgets_;  ///< Budgets per "pymodule:function", "pymodule:", or ":"
+  bool                                  memoryTracking_; ///< Track python allocation with tracemalloc during pymoduleCall
+  size_t                                trackedCalls_;   ///< pymoduleCalls in flight while memoryTracking_, only touched holding the GIL
+  bool                                  trackedOverlap_; ///< another pymoduleCall started while the accounted one was in flight
+  bool                                  tracingStarted_; ///< tracemalloc was started for tracked calls, stopped once none are in flight
+  SamplingProfiler                      profiler_;       ///< Python stack sampling attributed to "pymodule:function"
+  std::string                           profilePrefix_;  ///< Output prefix of profiler_ samples, empty if never started
+
+  // Value caching
+  std::map< std::string, std::shared_ptr< ValueCache > > valueCaches_; ///< Caches of embedValueFunc / embedValueCase per "pymodule.attr"
+  std::atomic< uint64_t >                                epoch_;       ///< Current epoch of CACHE_EPOCH values
+
+  // Output channels
+  std::map< std::string, std::unique_ptr< OutputChannel > > channels_;                ///< Channels per "pymodule.channel"
+  std::set< std::string >                                   channelHelpersEmbedded_;  ///< pymodules already provided emit()
+
+  // Lazy attributes of embedded modules, defined on first python access
+  std::map< std::string, std::map< std::string, std::function< void( pybind11::module_ & ) > > > pendingAttrs_; ///< Definitions per pymodule then attr
+
+  // Record and replay
+  TraceWriter  recorder_;      ///< Trace of embedded data and calls while recording
+  std::string  recordFile_;    ///< Trace file of recorder_
+  size_t       recordCalls_;   ///< pymoduleCall invocations to record, 0 for all until recordStop
+  size_t       recordedCalls_; ///< pymoduleCall invocations recorded so far
+
   // Python modules
   pybind11::module_   sys_;
   pybind11::function  sysPathAppend_;
+  pybind11::module_   tracemalloc_;
 
   
   bool autoLoad_; ///< Automatic loading of any used embedded python modules during runtime
@@ -92,26 +271,54 @@ EmbeddedInterpreter::embedPtr(
   FPE_GUARD_START( fpeTemp );
   // Get embedded module
   checkEmbeddedModuleLoaded( pymodule );
-  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+  embedArrayHelpers( pymodule );
+  checkAttrName( pymodule, attr );
+
+  // Keep a native description for access outside of python
+  {
+    EmbeddedArray array = makeEmbeddedArray( ptr, numDims, pDimSize, style == pybind11::array::f_style );
+
+    std::lock_guard< std::mutex > lock( embeddedArraysMutex_ );
+    std::map< std::string, EmbeddedArray > &arrays = embeddedArrays_[ pymodule ];
+    if ( arrays.find( attr ) != arrays.end() )
+    {
+      // Re-registration invalidates anything derived from the previous data
+      array.version = arrays[ attr ].version;
+      array.markDirty( 0, array.numElements() );
+    }
+    arrays[ attr ] = array;
+
+    if ( recorder_.isOpen() )
+    {
+      recorder_.array( pymodule, attr, array );
+    }
+  }
 
   // We are okay to make copies of these since they should be "small"
   pybind11::array::ShapeContainer dims = pybind11::array::ShapeContainer( std::vector< ssize_t >( pDimSize, pDimSize + numDims ) );
-  pybind11::str dummyDataOwner;
 
   // Add attribute to it
-  mod.def(
-          attr.c_str(),
-          // // Lambda
-          [=]() {
-                return 
-                  pybind11::array_t< T, style | pybind11::array::forcecast >( 
-                    dims,  // buffer dimensions
-                    static_cast< const T * >( ptr ),
-                    dummyDataOwner
-                    );
-          },
-          pybind11::return_value_policy::automatic_reference
-          );
+  defineAttr(
+              pymodule,
+              attr,
+              [=]( pybind11::module_ &mod )
+              {
+                pybind11::str dummyDataOwner;
+                mod.def(
+                        attr.c_str(),
+                        // // Lambda
+                        [=]() {
+                              return 
+                                pybind11::array_t< T, style | pybind11::array::forcecast >( 
+                                  dims,  // buffer dimensions
+                                  static_cast< const T * >( ptr ),
+                                  dummyDataOwner
+                                  );
+                        },
+                        pybind11::return_value_policy::automatic_reference
+                        );
+              }
+              );
   FPE_GUARD_STOP( fpeTemp );
 }
 
@@ -134,17 +341,24 @@ EmbeddedInterpreter::embedValue(
 
   // Get embedded module
   checkEmbeddedModuleLoaded( pymodule );
-  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+  checkAttrName( pymodule, attr );
 
   // Add attribute to it
-  mod.def(
-          attr.c_str(),
-          // Lambda
-          [=]() 
-          { 
-            return val;
-          }
-          );
+  defineAttr(
+              pymodule,
+              attr,
+              [=]( pybind11::module_ &mod )
+              {
+                mod.def(
+                        attr.c_str(),
+                        // Lambda
+                        [=]() 
+                        { 
+                          return recordValue( pymodule, attr, val );
+                        }
+                        );
+              }
+              );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -166,17 +380,26 @@ EmbeddedInterpreter::embedValueFunc(
 
   // Get embedded module
   checkEmbeddedModuleLoaded( pymodule );
-  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+  checkAttrName( pymodule, attr );
+
+  std::shared_ptr< CachedValue< T > > cache = makeValueCache< T >( pymodule, attr );
 
   // Add attribute to it
-  mod.def(
-          attr.c_str(),
-          // Lambda
-          [=]() 
-          { 
-            return func( ); 
-          }
-          );
+  defineAttr(
+              pymodule,
+              attr,
+              [=]( pybind11::module_ &mod )
+              {
+                mod.def(
+                        attr.c_str(),
+                        // Lambda
+                        [=]() 
+                        { 
+                          return recordValue( pymodule, attr, cachedValue( *cache, func ) ); 
+                        }
+                        );
+              }
+              );
 }
 
 
@@ -201,17 +424,164 @@ EmbeddedInterpreter::embedValueCase(
 
   // Get embedded module
   checkEmbeddedModuleLoaded( pymodule );
-  pybind11::module_ mod = pymodulesEmbedded_[ pymodule ];
+  checkAttrName( pymodule, attr );
+
+  std::shared_ptr< CachedValue< T > > cache = makeValueCache< T >( pymodule, attr );
+
+  // Built once so reads only pass it by reference to the cache
+  auto fetch = [func, attrCase]() { return func( attrCase.c_str() ); };
 
   // Add attribute to it
-  mod.def(
-          attr.c_str(),
-          // Lambda
-          [=]() 
-          { 
-            return func( attrCase.c_str() ); 
-          }
-          );
+  defineAttr(
+              pymodule,
+              attr,
+              [=]( pybind11::module_ &mod )
+              {
+                mod.def(
+                        attr.c_str(),
+                        // Lambda
+                        [=]() 
+                        { 
+                          return recordValue( pymodule, attr, cachedValue( *cache, fetch ) ); 
+                        }
+                        );
+              }
+              );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Passes through a value returned to python, recording it if a trace is open
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+T
+EmbeddedInterpreter::recordValue(
+                                  const std::string &pymodule, ///< Python module the value was embedded in
+                                  const std::string &attr,     ///< python attribute of the value
+                                  T                  val       ///< value being returned to python
+                                  )
+{
+  if ( recorder_.isOpen() )
+  {
+    recorder_.value( pymodule, attr, val );
+  }
+  return val;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Creates the cache of a newly embedded value, a re-registration keeps
+///        the policy of the value it replaces
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+std::shared_ptr< EmbeddedInterpreter::CachedValue< T > >
+EmbeddedInterpreter::makeValueCache(
+                                    const std::string &pymodule, ///< Python module the value is embedded in
+                                    const std::string &attr      ///< python attribute of the value
+                                    )
+{
+  std::shared_ptr< CachedValue< T > >  cache( new CachedValue< T >() );
+  std::shared_ptr< ValueCache >       &entry = valueCaches_[ pymodule + "." + attr ];
+  if ( entry )
+  {
+    cache->policy = entry->policy;
+  }
+  entry = cache;
+  return cache;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns the cached value if still valid under its policy, otherwise
+///        evaluates and caches it
+////////////////////////////////////////////////////////////////////////////////
+template< typename T, typename F >
+T
+EmbeddedInterpreter::cachedValue(
+                                  CachedValue< T > &cache,   ///< cache of the value
+                                  const F          &evaluate ///< callback into the embedding caller
+                                  )
+{
+  uint64_t epoch = epoch_.load( std::memory_order_relaxed );
+  if ( cache.valid && ( cache.policy == CACHE_ONCE || ( cache.policy == CACHE_EPOCH && cache.epoch == epoch ) ) )
+  {
+    cache.hits++;
+    return cache.value;
+  }
+
+  cache.misses++;
+  cache.value = evaluate();
+  cache.epoch = epoch;
+  cache.valid = cache.policy != CACHE_ALWAYS;
+  return cache.value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Creates a channel of records of recordLength T values that python
+///        appends to with pymodule.emit( "channel", records )
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void
+EmbeddedInterpreter::channelCreate(
+                                    std::string pymodule,     ///< Python module providing emit()
+                                    std::string channel,      ///< channel name used from python
+                                    size_t      recordLength, ///< T values per record
+                                    size_t      capacity      ///< records each thread may emit before a drain
+                                    )
+{
+  checkEmbeddedModuleLoaded( pymodule );
+  embedChannelHelpers( pymodule );
+
+  EmbeddedArray layout = makeEmbeddedArray( static_cast< T * >( 0 ), 0, static_cast< size_t * >( 0 ), false );
+  channels_[ pymodule + "." + channel ].reset( new OutputChannel( layout.kind, layout.itemSize, recordLength, capacity ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Moves up to maxRecords emitted records into buffer, returns the
+///        number of records moved - call outside of parallel regions
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+size_t
+EmbeddedInterpreter::channelDrain(
+                                  std::string  pymodule,  ///< Python module providing emit()
+                                  std::string  channel,   ///< channel name used from python
+                                  T           *buffer,    ///< [out] room for maxRecords records
+                                  size_t       maxRecords ///< records buffer can hold
+                                  )
+{
+  OutputChannel &out    = findChannel( pymodule, channel );
+  EmbeddedArray  layout = makeEmbeddedArray( static_cast< T * >( 0 ), 0, static_cast< size_t * >( 0 ), false );
+  if ( out.kind() != layout.kind || out.itemSize() != layout.itemSize )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Channel '" << pymodule << "." << channel << "' does not hold '" << layout.descr() << "' records" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+  return out.drain( buffer, maxRecords );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Appends python records converted to T to a channel, returns the number
+///        of records accepted
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+size_t
+EmbeddedInterpreter::channelEmit(
+                                  OutputChannel    &channel, ///< channel to append to
+                                  pybind11::object  records  ///< anything numpy can convert, flattened into records
+                                  )
+{
+  pybind11::array_t< T, pybind11::array::c_style | pybind11::array::forcecast > values = records.cast< pybind11::array_t< T, pybind11::array::c_style | pybind11::array::forcecast > >();
+
+  size_t numValues = static_cast< size_t >( values.size() );
+  if ( numValues % channel.recordLength() != 0 )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: " << numValues << " values do not form whole records of " << channel.recordLength() << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+  // Held for the copy, python threads and nested teams share a thread number and so a ring
+  return channel.emit( values.data(), numValues / channel.recordLength() );
 }
 
 extern "C"
@@ -228,6 +598,12 @@ void                  EmbeddedInterpreter_threadingFinalize( EmbeddedInterpreter
 void                  EmbeddedInterpreter_addToScope( EmbeddedInterpreter *pObj, char *directory );
 void                  EmbeddedInterpreter_pymoduleLoad        ( EmbeddedInterpreter *pObj, char *pymodule );
 void                  EmbeddedInterpreter_pymoduleCall        ( EmbeddedInterpreter *pObj, char *pymodule, char *function );
+void                  EmbeddedInterpreter_memoryTracking      ( EmbeddedInterpreter *pObj, bool enable );
+void                  EmbeddedInterpreter_memoryBudget        ( EmbeddedInterpreter *pObj, char *pymodule, char *function, size_t bytes, int action );
+void                  EmbeddedInterpreter_profilerStart       ( EmbeddedInterpreter *pObj, double hz, char *prefix );
+void                  EmbeddedInterpreter_profilerStop        ( EmbeddedInterpreter *pObj );
+void                  EmbeddedInterpreter_recordStart         ( EmbeddedInterpreter *pObj, char *filename, size_t numCalls );
+void                  EmbeddedInterpreter_recordStop          ( EmbeddedInterpreter *pObj );
 void                  EmbeddedInterpreter_embeddedPymoduleLoad( EmbeddedInterpreter *pObj, char *pymodule );
 
 void                  EmbeddedInterpreter_embedDoublePtr      ( EmbeddedInterpreter *pObj, char *pymodule, char *attr, double  *ptr, size_t numDims, size_t *pDimSize );
@@ -250,6 +626,26 @@ void                  EmbeddedInterpreter_embedDoubleValueCase( EmbeddedInterpre
 void                  EmbeddedInterpreter_embedFloatValueCase ( EmbeddedInterpreter *pObj, char *pymodule, char *attr, char  *attrCase,   float(*func)(const char*) );
 void                  EmbeddedInterpreter_embedInt32ValueCase ( EmbeddedInterpreter *pObj, char *pymodule, char *attr, char  *attrCase, int32_t(*func)(const char*) );
 
+void                  EmbeddedInterpreter_valueCache          ( EmbeddedInterpreter *pObj, char *pymodule, char *attr, int policy );
+void                  EmbeddedInterpreter_advanceEpoch        ( EmbeddedInterpreter *pObj );
+
+void                  EmbeddedInterpreter_channelCreateDouble ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t recordLength, size_t capacity );
+void                  EmbeddedInterpreter_channelCreateFloat  ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t recordLength, size_t capacity );
+void                  EmbeddedInterpreter_channelCreateInt32  ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t recordLength, size_t capacity );
+
+void                  EmbeddedInterpreter_channelDrainDouble  ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, double  *buffer, size_t maxRecords, size_t *pNumRecords );
+void                  EmbeddedInterpreter_channelDrainFloat   ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, float   *buffer, size_t maxRecords, size_t *pNumRecords );
+void                  EmbeddedInterpreter_channelDrainInt32   ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, int32_t *buffer, size_t maxRecords, size_t *pNumRecords );
+void                  EmbeddedInterpreter_channelPending      ( EmbeddedInterpreter *pObj, char *pymodule, char *channel, size_t *pNumRecords );
+
+void                  EmbeddedInterpreter_arrayDump         ( EmbeddedInterpreter *pObj, char *pymodule, char *attr, char *filename, int mode );
+void                  EmbeddedInterpreter_arrayDumpModule   ( EmbeddedInterpreter *pObj, char *pymodule, char *directory, int mode );
+void                  EmbeddedInterpreter_arrayDumpContainer( EmbeddedInterpreter *pObj, char *pymodule, char *filename, int mode );
+void                  EmbeddedInterpreter_arrayDumpWait     ( EmbeddedInterpreter *pObj );
+
+void                  EmbeddedInterpreter_markDirty         ( EmbeddedInterpreter *pObj, char *pymodule, char *attr );
+void                  EmbeddedInterpreter_markDirtyRange    ( EmbeddedInterpreter *pObj, char *pymodule, char *attr, size_t first, size_t last );
+
 
 
 }
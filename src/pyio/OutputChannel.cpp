@@ -0,0 +1,197 @@
+#include "OutputChannel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ctor, one ring of capacity records per possible OpenMP thread
+////////////////////////////////////////////////////////////////////////////////
+OutputChannel::OutputChannel(
+                              char   kind,         ///< numpy type kind of elements
+                              size_t itemSize,     ///< bytes per element
+                              size_t recordLength, ///< elements per record
+                              size_t capacity      ///< records each producer thread may hold before draining
+                              )
+  : kind_( kind ),
+    itemSize_( itemSize ),
+    recordLength_( recordLength ),
+    recordBytes_( itemSize * recordLength ),
+    capacity_( capacity )
+{
+  if ( recordLength == 0 || capacity == 0 )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: Output channel requires a non-zero record length and capacity" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+
+#ifdef _OPENMP
+  size_t numRings = static_cast< size_t >( omp_get_max_threads() );
+#else
+  size_t numRings = 1;
+#endif
+
+  for ( size_t i = 0; i < numRings; i++ )
+  {
+    void *pMemory = 0;
+    if ( posix_memalign( &pMemory, alignof( Ring ), sizeof( Ring ) ) != 0 )
+    {
+      std::stringstream ss;
+      ss << __FILE__ << ":" << __LINE__ << " : Error: Failed to allocate output channel ring" << std::endl;
+      std::cerr << ss.str();
+      throw std::runtime_error( ss.str() );
+    }
+    std::unique_ptr< Ring, RingDeleter > ring( new ( pMemory ) Ring() );
+    ring->head    = 0;
+    ring->tail    = 0;
+    ring->dropped = 0;
+    ring->data.resize( capacity_ * recordBytes_ );
+    rings_.push_back( std::move( ring ) );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Dtor
+////////////////////////////////////////////////////////////////////////////////
+OutputChannel::~OutputChannel()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Destroys a ring placed in memory from posix_memalign
+////////////////////////////////////////////////////////////////////////////////
+void
+OutputChannel::RingDeleter::operator()(
+                                        Ring *pRing ///< ring to free
+                                        ) const
+{
+  pRing->~Ring();
+  free( pRing );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Appends records to the calling thread's ring, returns the number
+///        accepted with the remainder dropped
+////////////////////////////////////////////////////////////////////////////////
+size_t
+OutputChannel::emit(
+                    const void *records,   ///< numRecords contiguous records
+                    size_t      numRecords ///< number of records
+                    )
+{
+  Ring  &ring = producerRing();
+  size_t tail = ring.tail.load( std::memory_order_relaxed );
+  size_t head = ring.head.load( std::memory_order_acquire );
+  size_t n    = std::min( numRecords, capacity_ - ( tail - head ) );
+
+  // At most two segments around the end of the ring
+  const char *src   = static_cast< const char * >( records );
+  size_t      start = tail % capacity_;
+  size_t      first = std::min( n, capacity_ - start );
+  std::memcpy( &ring.data[ start * recordBytes_ ], src, first * recordBytes_ );
+  std::memcpy( &ring.data[ 0 ], src + first * recordBytes_, ( n - first ) * recordBytes_ );
+
+  ring.tail.store( tail + n, std::memory_order_release );
+  if ( n < numRecords )
+  {
+    ring.dropped.fetch_add( numRecords - n, std::memory_order_relaxed );
+  }
+  return n;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Moves up to maxRecords from all rings into out, ring by ring in
+///        emission order, returns the number of records moved
+///
+/// Only a single thread may drain at a time
+////////////////////////////////////////////////////////////////////////////////
+size_t
+OutputChannel::drain(
+                      void   *out,       ///< [out] room for maxRecords records
+                      size_t  maxRecords ///< records out can hold
+                      )
+{
+  char  *dst   = static_cast< char * >( out );
+  size_t total = 0;
+
+  for ( size_t i = 0; i < rings_.size() && total < maxRecords; i++ )
+  {
+    Ring  &ring = *rings_[i];
+    size_t head = ring.head.load( std::memory_order_relaxed );
+    size_t tail = ring.tail.load( std::memory_order_acquire );
+    size_t n    = std::min( tail - head, maxRecords - total );
+
+    size_t start = head % capacity_;
+    size_t first = std::min( n, capacity_ - start );
+    std::memcpy( dst, &ring.data[ start * recordBytes_ ], first * recordBytes_ );
+    std::memcpy( dst + first * recordBytes_, &ring.data[ 0 ], ( n - first ) * recordBytes_ );
+
+    ring.head.store( head + n, std::memory_order_release );
+    dst   += n * recordBytes_;
+    total += n;
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Records waiting to be drained across all rings
+////////////////////////////////////////////////////////////////////////////////
+size_t
+OutputChannel::pending() const
+{
+  size_t total = 0;
+  for ( size_t i = 0; i < rings_.size(); i++ )
+  {
+    total += rings_[i]->tail.load( std::memory_order_acquire ) - rings_[i]->head.load( std::memory_order_relaxed );
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Records dropped so far because a ring was full
+////////////////////////////////////////////////////////////////////////////////
+size_t
+OutputChannel::dropped() const
+{
+  size_t total = 0;
+  for ( size_t i = 0; i < rings_.size(); i++ )
+  {
+    total += rings_[i]->dropped.load( std::memory_order_relaxed );
+  }
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ring of the calling thread, threads numbered beyond the rings made
+///        at construction would share a ring and break its single producer
+////////////////////////////////////////////////////////////////////////////////
+OutputChannel::Ring &
+OutputChannel::producerRing()
+{
+#ifdef _OPENMP
+  size_t thread = static_cast< size_t >( omp_get_thread_num() );
+  if ( thread >= rings_.size() )
+  {
+    std::stringstream ss;
+    ss << __FILE__ << ":" << __LINE__ << " : Error: OpenMP thread " << thread << " emitted to a channel created for "
+       << rings_.size() << " threads, create channels after setting the thread count" << std::endl;
+    std::cerr << ss.str();
+    throw std::runtime_error( ss.str() );
+  }
+  return *rings_[ thread ];
+#else
+  return *rings_[0];
+#endif
+}
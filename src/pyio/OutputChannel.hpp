@@ -0,0 +1,73 @@
+#ifndef OutputChannel_hpp
+#define OutputChannel_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Typed fixed-size records passed from python back to the embedding
+///        caller through per-thread lock-free ring buffers
+///
+/// Each producer thread appends to its own single-producer single-consumer
+/// ring, selected by OpenMP thread number, so producers never contend with
+/// one another. Rings are made for omp_get_max_threads() at construction, an
+/// emit from a thread numbered beyond that throws. The embedding caller drains
+/// all rings after the parallel region. Records that do not fit are dropped
+/// and counted rather than blocking the producer
+///
+/// Threads of different teams, or python threads, share a thread number and so
+/// a ring, emit() must therefore be serialized among them, e.g. by the GIL
+////////////////////////////////////////////////////////////////////////////////
+class OutputChannel
+{
+public:
+  // Ctor Dtor
+  OutputChannel( char kind, size_t itemSize, size_t recordLength, size_t capacity );
+  virtual ~OutputChannel();
+
+  size_t emit   ( const void *records, size_t numRecords );
+  size_t drain  ( void *out, size_t maxRecords );
+  size_t pending() const;
+  size_t dropped() const;
+
+  char   kind        () const { return kind_;         }
+  size_t itemSize    () const { return itemSize_;     }
+  size_t recordLength() const { return recordLength_; }
+
+private:
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Single-producer single-consumer ring, head and tail only ever grow
+  ///        and sit on separate cache lines to keep producer and consumer off
+  ///        each other's
+  ////////////////////////////////////////////////////////////////////////////////
+  struct alignas( 64 ) Ring
+  {
+    alignas( 64 ) std::atomic< size_t > head;    ///< records consumed, written by the consumer
+    alignas( 64 ) std::atomic< size_t > tail;    ///< records produced, written by the producer
+                  std::atomic< size_t > dropped; ///< records that did not fit, written by the producer
+    alignas( 64 ) std::vector< char >   data;    ///< capacity records, only read once created
+  };
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// \brief Frees a Ring from its over-aligned allocation, plain new does not
+  ///        honour alignas( 64 ) before C++17
+  ////////////////////////////////////////////////////////////////////////////////
+  struct RingDeleter
+  {
+    void operator()( Ring *pRing ) const;
+  };
+
+  Ring &producerRing();
+
+  char                                                kind_;         ///< numpy type kind of elements
+  size_t                                              itemSize_;     ///< bytes per element
+  size_t                                              recordLength_; ///< elements per record
+  size_t                                              recordBytes_;  ///< bytes per record
+  size_t                                              capacity_;     ///< records per ring
+  std::vector< std::unique_ptr< Ring, RingDeleter > > rings_;        ///< one ring per producer thread
+};
+
+#endif
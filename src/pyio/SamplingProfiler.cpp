@@ -0,0 +1,272 @@
+#include "SamplingProfiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "pybind11/pybind11.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ctor
+////////////////////////////////////////////////////////////////////////////////
+SamplingProfiler::SamplingProfiler()
+  : running_( false ),
+    active_( false ),
+    tracedPeak_( 0 ),
+    interval_( 0.0 )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Dtor
+////////////////////////////////////////////////////////////////////////////////
+SamplingProfiler::~SamplingProfiler()
+{
+  stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Starts sampling in-flight calls, previous samples are kept
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::start(
+                        double hz ///< samples per second per in-flight call
+                        )
+{
+  if ( hz <= 0.0 || thread_.joinable() )
+  {
+    return;
+  }
+
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    interval_ = 1.0 / hz;
+    running_  = true;
+  }
+  active_ = true;
+  thread_ = std::thread( &SamplingProfiler::run, this );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Stops sampling and joins the sampler
+///
+/// The sampler may be waiting on the GIL, so it is released here if held
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::stop()
+{
+  if ( !thread_.joinable() )
+  {
+    return;
+  }
+
+  active_ = false;
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    running_ = false;
+    inFlight_.clear();
+  }
+  wakeup_.notify_all();
+
+  PyThreadState *pSaved = PyGILState_Check() ? PyEval_SaveThread() : 0;
+  thread_.join();
+  if ( pSaved )
+  {
+    PyEval_RestoreThread( pSaved );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writes samples as folded stacks, nothing is written if no samples
+////////////////////////////////////////////////////////////////////////////////
+bool
+SamplingProfiler::write(
+                        std::string filename ///< output file
+                        )
+{
+  std::lock_guard< std::mutex > lock( mutex_ );
+  if ( folded_.empty() )
+  {
+    return false;
+  }
+
+  std::ofstream out( filename.c_str(), std::ios::out | std::ios::trunc );
+  for ( std::map< std::string, size_t >::iterator it = folded_.begin(); it != folded_.end(); ++it )
+  {
+    out << it->first << " " << it->second << "\n";
+  }
+  return static_cast< bool >( out );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Marks the calling thread as within a call to attribute samples to,
+///        GIL must be held
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::callEnter(
+                            const std::string &label ///< attribution of samples e.g. "pymodule:function"
+                            )
+{
+  if ( !active_ )
+  {
+    return;
+  }
+  std::lock_guard< std::mutex > lock( mutex_ );
+  inFlight_[ PyThread_get_thread_ident() ] = label;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Marks the calling thread as no longer within a call, GIL must be held
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::callExit()
+{
+  if ( !active_ )
+  {
+    return;
+  }
+  std::lock_guard< std::mutex > lock( mutex_ );
+  inFlight_.erase( PyThread_get_thread_ident() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Forgets any displaced tracemalloc peak, GIL must be held
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::resetTracedPeak()
+{
+  tracedPeak_ = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Highest tracemalloc peak the sampler reset to keep its own
+///        allocations out, since resetTracedPeak(), GIL must be held
+////////////////////////////////////////////////////////////////////////////////
+size_t
+SamplingProfiler::tracedPeak() const
+{
+  return tracedPeak_;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Sampler loop
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::run()
+{
+  std::unique_lock< std::mutex > lock( mutex_ );
+  while ( running_ )
+  {
+    wakeup_.wait_for( lock, std::chrono::duration< double >( interval_ ) );
+    if ( !running_ || inFlight_.empty() )
+    {
+      // Nothing in flight, do not bother the GIL
+      continue;
+    }
+
+    lock.unlock();
+    sample();
+    lock.lock();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Takes the GIL and samples, keeping the sampler's allocations out of
+///        any tracemalloc peak
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::sample()
+{
+  PyGILState_STATE state = PyGILState_Ensure();
+  try
+  {
+    // Only consulted if python already imported it
+    pybind11::dict   modules     = pybind11::module_::import( "sys" ).attr( "modules" ).cast< pybind11::dict >();
+    pybind11::object tracemalloc = modules.contains( "tracemalloc" ) ? pybind11::object( modules[ "tracemalloc" ] ) : pybind11::object( pybind11::none() );
+    bool             tracing     = !tracemalloc.is_none() && pybind11::hasattr( tracemalloc, "reset_peak" ) && tracemalloc.attr( "is_tracing" )().cast< bool >();
+    size_t           peakBefore  = tracing ? tracemalloc.attr( "get_traced_memory" )().cast< pybind11::tuple >()[1].cast< size_t >() : 0;
+
+    sampleStacks();
+
+    if ( tracing && tracemalloc.attr( "get_traced_memory" )().cast< pybind11::tuple >()[1].cast< size_t >() > peakBefore )
+    {
+      // Only the sampler and callers holding the GIL touch tracedPeak_
+      tracedPeak_ = std::max( tracedPeak_.load(), peakBefore );
+      tracemalloc.attr( "reset_peak" )();
+    }
+  }
+  catch ( const std::exception & )
+  {
+    // Sampling is best effort, just drop this sample
+  }
+  PyGILState_Release( state );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Records the python stack of every thread within a call, GIL must
+///        be held
+////////////////////////////////////////////////////////////////////////////////
+void
+SamplingProfiler::sampleStacks()
+{
+  // callEnter / callExit happen under the GIL, so this is now stable
+  std::map< unsigned long, std::string > inFlight;
+  {
+    std::lock_guard< std::mutex > lock( mutex_ );
+    inFlight = inFlight_;
+  }
+
+  std::vector< std::string > stacks;
+  try
+  {
+    pybind11::dict frames = pybind11::module_::import( "sys" ).attr( "_current_frames" )().cast< pybind11::dict >();
+
+    for ( std::map< unsigned long, std::string >::iterator it = inFlight.begin(); it != inFlight.end(); ++it )
+    {
+      pybind11::int_ ident( it->first );
+      if ( !frames.contains( ident ) )
+      {
+        continue;
+      }
+
+      // Walk inner to outer
+      std::vector< std::string > frameNames;
+      pybind11::object frame = frames[ ident ];
+      while ( !frame.is_none() )
+      {
+        pybind11::object code     = frame.attr( "f_code" );
+        std::string      filename = code.attr( "co_filename" ).cast< std::string >();
+        size_t           slash    = filename.find_last_of( '/' );
+
+        std::stringstream name;
+        name << code.attr( "co_name" ).cast< std::string >()
+             << " (" << ( slash == std::string::npos ? filename : filename.substr( slash + 1 ) )
+             << ":"  << frame.attr( "f_lineno" ).cast< int >() << ")";
+        frameNames.push_back( name.str() );
+
+        frame = frame.attr( "f_back" );
+      }
+
+      std::string stack = it->second;
+      for ( std::vector< std::string >::reverse_iterator name = frameNames.rbegin(); name != frameNames.rend(); ++name )
+      {
+        stack += ";" + *name;
+      }
+      stacks.push_back( stack );
+    }
+  }
+  catch ( const std::exception & )
+  {
+    // Frames may disappear beneath us, just drop this sample
+  }
+
+  std::lock_guard< std::mutex > lock( mutex_ );
+  for ( size_t i = 0; i < stacks.size(); i++ )
+  {
+    folded_[ stacks[i] ]++;
+  }
+}
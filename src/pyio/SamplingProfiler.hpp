@@ -0,0 +1,59 @@
+#ifndef SamplingProfiler_hpp
+#define SamplingProfiler_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "pybind11/pybind11.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Low-rate sampler of python stacks, only while calls are in flight
+///
+/// A native thread wakes at the requested rate and, if any thread is within a
+/// call marked by callEnter() / callExit(), takes the GIL and records the python
+/// stack of those threads attributed to the call's label. Results are written
+/// in folded-stack format ( "label;outer;...;inner count" ) for flamegraph tools
+///
+/// While tracemalloc is tracing, the sampler's own allocations would count
+/// towards the peak of the call being measured. Any peak it raises is reset,
+/// with the peak it displaced kept in tracedPeak()
+////////////////////////////////////////////////////////////////////////////////
+class SamplingProfiler
+{
+public:
+  // Ctor Dtor
+  SamplingProfiler();
+  virtual ~SamplingProfiler();
+
+  void start( double hz );
+  void stop ();
+  bool write( std::string filename );
+
+  void callEnter( const std::string &label );
+  void callExit ();
+
+  void   resetTracedPeak();
+  size_t tracedPeak     () const;
+
+private:
+  void run();
+  void sample();
+  void sampleStacks();
+
+  std::thread                            thread_;     ///< sampler, alive between start() and stop()
+  std::mutex                             mutex_;      ///< guards running_, interval_, inFlight_, folded_
+  std::condition_variable                wakeup_;     ///< interrupts the sampling interval on stop()
+  bool                                   running_;    ///< sampler should keep going
+  std::atomic< bool >                    active_;     ///< cheap check for callEnter / callExit
+  std::atomic< size_t >                  tracedPeak_; ///< tracemalloc peak displaced by sampling since resetTracedPeak()
+  double                                 interval_;   ///< seconds between samples
+  std::map< unsigned long, std::string > inFlight_;   ///< python thread ident to label of the call it is within
+  std::map< std::string, size_t >        folded_;     ///< folded stack to number of samples
+};
+
+#endif
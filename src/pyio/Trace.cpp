@@ -0,0 +1,416 @@
+#include "Trace.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define TRACE_MAGIC      "PYIOTRC1"
+#define TRACE_MAGIC_SIZE 8
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Word-wise hash of raw bytes, used to skip rewriting unchanged arrays
+///        the embedding caller does not mark dirty
+///
+/// Four independent multiply-xorshift lanes keep the multiplier latency off
+/// the critical path so large arrays hash at close to memory bandwidth
+////////////////////////////////////////////////////////////////////////////////
+static uint64_t
+hashWords( const void *ptr, size_t size )
+{
+  const uint64_t       prime  = 0x9e3779b97f4a7c15ULL;
+  const unsigned char *bytes  = static_cast< const unsigned char * >( ptr );
+  size_t               blocks = size / ( 4 * sizeof( uint64_t ) );
+  uint64_t             lane[4] = { size, size ^ 1, size ^ 2, size ^ 3 };
+
+  for ( size_t i = 0; i < blocks; i++ )
+  {
+    uint64_t words[4];
+    std::memcpy( words, bytes + i * sizeof( words ), sizeof( words ) );
+    for ( int j = 0; j < 4; j++ )
+    {
+      lane[j]  = ( lane[j] ^ words[j] ) * prime;
+      lane[j] ^= lane[j] >> 29;
+    }
+  }
+
+  uint64_t hash = lane[0] ^ ( lane[1] * prime ) ^ ( lane[2] * prime * prime ) ^ ( lane[3] * prime * prime * prime );
+  for ( size_t i = blocks * 4 * sizeof( uint64_t ); i < size; i++ )
+  {
+    hash = ( hash ^ bytes[i] ) * prime;
+  }
+  return hash ^ ( hash >> 32 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Report a trace I/O failure
+////////////////////////////////////////////////////////////////////////////////
+static void
+traceError( const std::string &message )
+{
+  std::stringstream ss;
+  ss << __FILE__ << ":" << __LINE__ << " : Error: " << message << std::endl;
+  std::cerr << ss.str();
+  throw std::runtime_error( ss.str() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ctor
+////////////////////////////////////////////////////////////////////////////////
+TraceWriter::TraceWriter()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Dtor
+////////////////////////////////////////////////////////////////////////////////
+TraceWriter::~TraceWriter()
+{
+  close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Starts a new trace, truncating filename
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::open(
+                  std::string filename ///< trace file
+                  )
+{
+  close();
+  recorded_.clear();
+
+  out_.open( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+  if ( !out_ )
+  {
+    traceError( "Failed to open trace '" + filename + "' for writing" );
+  }
+  out_.write( TRACE_MAGIC, TRACE_MAGIC_SIZE );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Terminates and closes the trace if open
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::close()
+{
+  if ( out_.is_open() )
+  {
+    out_.put( TraceRecord::END );
+    out_.close();
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Whether a trace is being written
+////////////////////////////////////////////////////////////////////////////////
+bool
+TraceWriter::isOpen() const
+{
+  return out_.is_open();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record addToScope
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::scope(
+                    const std::string &directory ///< directory added to sys.path
+                    )
+{
+  out_.put( TraceRecord::SCOPE );
+  writeString( std::string() );
+  writeString( directory );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record embeddedPymoduleLoad
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::embeddedLoad(
+                          const std::string &pymodule ///< embedded python module loaded
+                          )
+{
+  out_.put( TraceRecord::EMBEDDED_LOAD );
+  writeString( pymodule );
+  writeString( std::string() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record pymoduleLoad
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::moduleLoad(
+                        const std::string &pymodule ///< user python module loaded
+                        )
+{
+  out_.put( TraceRecord::MODULE_LOAD );
+  writeString( pymodule );
+  writeString( std::string() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record the layout of an array from embedPtr, contents are forgotten
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::array(
+                    const std::string   &pymodule, ///< Python module the array was embedded in
+                    const std::string   &attr,     ///< python attribute of the array
+                    const EmbeddedArray &array     ///< layout of the array
+                    )
+{
+  out_.put( TraceRecord::ARRAY );
+  writeString( pymodule );
+  writeString( attr );
+  out_.put( array.kind );
+  writeSize( array.itemSize );
+  out_.put( array.fortranOrder ? 1 : 0 );
+  writeSize( array.dims.size() );
+  for ( size_t i = 0; i < array.dims.size(); i++ )
+  {
+    writeSize( array.dims[i] );
+  }
+
+  recorded_.erase( pymodule + "." + attr );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record the contents of an array from embedPtr if changed since last recorded
+///
+/// Compared by version and by hash, a version bump is recorded even if the
+/// contents are unchanged, and writes the embedding caller or python made
+/// without marking the array are still caught by the hash
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::data(
+                  const std::string   &pymodule, ///< Python module the array was embedded in
+                  const std::string   &attr,     ///< python attribute of the array
+                  const EmbeddedArray &array     ///< array to record
+                  )
+{
+  std::pair< uint64_t, uint64_t > stamp( array.version, hashWords( array.ptr, array.numBytes() ) );
+
+  std::map< std::string, std::pair< uint64_t, uint64_t > >::iterator last = recorded_.find( pymodule + "." + attr );
+  if ( last != recorded_.end() && last->second == stamp )
+  {
+    return;
+  }
+  recorded_[ pymodule + "." + attr ] = stamp;
+
+  out_.put( TraceRecord::DATA );
+  writeString( pymodule );
+  writeString( attr );
+  writeSize( array.numBytes() );
+  out_.write( static_cast< const char * >( array.ptr ), array.numBytes() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record pymoduleCall
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::call(
+                  const std::string &pymodule, ///< user python module called
+                  const std::string &function  ///< function invoked
+                  )
+{
+  out_.put( TraceRecord::CALL );
+  writeString( pymodule );
+  writeString( function );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record a raw value
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::writeValue(
+                        const std::string &pymodule, ///< Python module the value was embedded in
+                        const std::string &attr,     ///< python attribute of the value
+                        char               kind,     ///< numpy type kind of the value
+                        size_t             itemSize, ///< size of the value
+                        const void        *ptr       ///< value
+                        )
+{
+  out_.put( TraceRecord::VALUE );
+  writeString( pymodule );
+  writeString( attr );
+  out_.put( kind );
+  writeSize( itemSize );
+  out_.write( static_cast< const char * >( ptr ), itemSize );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Length prefixed string
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::writeString(
+                          const std::string &str ///< string to write
+                          )
+{
+  uint32_t length = static_cast< uint32_t >( str.size() );
+  out_.write( reinterpret_cast< const char * >( &length ), sizeof( length ) );
+  out_.write( str.data(), length );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Fixed width size
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceWriter::writeSize(
+                        uint64_t size ///< size to write
+                        )
+{
+  out_.write( reinterpret_cast< const char * >( &size ), sizeof( size ) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Ctor
+////////////////////////////////////////////////////////////////////////////////
+TraceReader::TraceReader()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Dtor
+////////////////////////////////////////////////////////////////////////////////
+TraceReader::~TraceReader()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Opens a trace and validates its magic
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceReader::open(
+                  std::string filename ///< trace file
+                  )
+{
+  filename_ = filename;
+  in_.open( filename.c_str(), std::ios::in | std::ios::binary );
+
+  char magic[ TRACE_MAGIC_SIZE ];
+  if ( !in_ || !in_.read( magic, TRACE_MAGIC_SIZE ) || std::memcmp( magic, TRACE_MAGIC, TRACE_MAGIC_SIZE ) != 0 )
+  {
+    traceError( "'" + filename + "' is not a pyio trace" );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Returns to the first record
+////////////////////////////////////////////////////////////////////////////////
+void
+TraceReader::rewind()
+{
+  in_.clear();
+  in_.seekg( TRACE_MAGIC_SIZE, std::ios::beg );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Reads the next record, false at end of trace
+////////////////////////////////////////////////////////////////////////////////
+bool
+TraceReader::next(
+                  TraceRecord &record,   ///< [out] record read
+                  bool         skipBytes ///< seek past DATA contents instead of reading them
+                  )
+{
+  int type = in_.get();
+  if ( type == std::char_traits< char >::eof() || type == TraceRecord::END )
+  {
+    return false;
+  }
+
+  record.type         = static_cast< char >( type );
+  record.pymodule     = readString();
+  record.attr         = readString();
+  record.kind         = 0;
+  record.itemSize     = 0;
+  record.fortranOrder = false;
+  record.dims.clear();
+  record.bytes.clear();
+
+  switch ( record.type )
+  {
+    case TraceRecord::ARRAY :
+    {
+      record.kind         = static_cast< char >( in_.get() );
+      record.itemSize     = readSize();
+      record.fortranOrder = in_.get() != 0;
+      record.dims.resize( readSize() );
+      for ( size_t i = 0; i < record.dims.size(); i++ )
+      {
+        record.dims[i] = readSize();
+      }
+      break;
+    }
+    case TraceRecord::DATA :
+    {
+      uint64_t size = readSize();
+      if ( skipBytes )
+      {
+        in_.seekg( size, std::ios::cur );
+      }
+      else
+      {
+        record.bytes.resize( size );
+        in_.read( record.bytes.data(), size );
+      }
+      break;
+    }
+    case TraceRecord::VALUE :
+    {
+      record.kind     = static_cast< char >( in_.get() );
+      record.itemSize = readSize();
+      record.bytes.resize( record.itemSize );
+      in_.read( record.bytes.data(), record.itemSize );
+      break;
+    }
+    case TraceRecord::SCOPE :
+    case TraceRecord::EMBEDDED_LOAD :
+    case TraceRecord::MODULE_LOAD :
+    case TraceRecord::CALL :
+      break;
+    default :
+    {
+      std::stringstream ss;
+      ss << "Corrupt trace '" << filename_ << "', unknown record type " << type;
+      traceError( ss.str() );
+    }
+  }
+
+  if ( !in_ )
+  {
+    traceError( "Truncated trace '" + filename_ + "'" );
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Length prefixed string
+////////////////////////////////////////////////////////////////////////////////
+std::string
+TraceReader::readString()
+{
+  uint32_t length = 0;
+  in_.read( reinterpret_cast< char * >( &length ), sizeof( length ) );
+
+  std::string str( length, '\0' );
+  if ( length > 0 )
+  {
+    in_.read( &str[0], length );
+  }
+  return str;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Fixed width size
+////////////////////////////////////////////////////////////////////////////////
+uint64_t
+TraceReader::readSize()
+{
+  uint64_t size = 0;
+  in_.read( reinterpret_cast< char * >( &size ), sizeof( size ) );
+  return size;
+}
@@ -0,0 +1,117 @@
+#ifndef Trace_hpp
+#define Trace_hpp
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "EmbeddedArray.hpp"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Single entry of a record-and-replay trace
+////////////////////////////////////////////////////////////////////////////////
+struct TraceRecord
+{
+  enum Type
+  {
+    SCOPE         = 'S', ///< addToScope( attr )
+    EMBEDDED_LOAD = 'E', ///< embeddedPymoduleLoad( pymodule )
+    MODULE_LOAD   = 'L', ///< pymoduleLoad( pymodule )
+    ARRAY         = 'A', ///< embedPtr layout of pymodule.attr
+    DATA          = 'D', ///< contents of pymodule.attr in bytes
+    VALUE         = 'V', ///< single value returned to python by pymodule.attr(), in bytes
+    CALL          = 'C', ///< pymoduleCall( pymodule, attr )
+    END           = 'Z'  ///< end of trace
+  };
+
+  char                  type;         ///< TraceRecord::Type
+  std::string           pymodule;     ///< Python module operated on
+  std::string           attr;         ///< attribute, function, or directory depending on type
+  char                  kind;         ///< numpy type kind of ARRAY / VALUE
+  size_t                itemSize;     ///< element size of ARRAY / VALUE
+  bool                  fortranOrder; ///< ARRAY layout
+  std::vector< size_t > dims;         ///< ARRAY dims
+  std::vector< char >   bytes;        ///< DATA / VALUE contents
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Writes a compact binary trace of embedded data and calls
+///
+/// Layout is the magic "PYIOTRC1" followed by records of a type byte, pymodule
+/// and attr strings, then type-specific fields. Strings are a uint32 length then
+/// characters, sizes are uint64, all in native byte order. Array contents are
+/// only written when their EmbeddedArray::version or their hash changed since
+/// last written, so writes never marked dirty are recorded as well
+////////////////////////////////////////////////////////////////////////////////
+class TraceWriter
+{
+public:
+  // Ctor Dtor
+  TraceWriter();
+  virtual ~TraceWriter();
+
+  void open ( std::string filename );
+  void close();
+  bool isOpen() const;
+
+  void scope       ( const std::string &directory );
+  void embeddedLoad( const std::string &pymodule );
+  void moduleLoad  ( const std::string &pymodule );
+  void array       ( const std::string &pymodule, const std::string &attr, const EmbeddedArray &array );
+  void data        ( const std::string &pymodule, const std::string &attr, const EmbeddedArray &array );
+  void call        ( const std::string &pymodule, const std::string &function );
+
+  template< typename T >
+  void value( const std::string &pymodule, const std::string &attr, T val );
+
+private:
+  void writeString( const std::string &str );
+  void writeSize  ( uint64_t size );
+  void writeValue ( const std::string &pymodule, const std::string &attr, char kind, size_t itemSize, const void *ptr );
+
+  std::ofstream                                            out_;      ///< trace file
+  std::map< std::string, std::pair< uint64_t, uint64_t > > recorded_; ///< ( version, hash ) of last written contents per "pymodule.attr"
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Reads back a trace written by TraceWriter
+////////////////////////////////////////////////////////////////////////////////
+class TraceReader
+{
+public:
+  // Ctor Dtor
+  TraceReader();
+  virtual ~TraceReader();
+
+  void open  ( std::string filename );
+  void rewind();
+  bool next  ( TraceRecord &record, bool skipBytes = false );
+
+private:
+  std::string readString();
+  uint64_t    readSize  ();
+
+  std::ifstream in_;       ///< trace file
+  std::string   filename_; ///< trace file name for reporting
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Record a single value returned to python
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+void
+TraceWriter::value(
+                    const std::string &pymodule, ///< Python module the value was embedded in
+                    const std::string &attr,     ///< python attribute of the value
+                    T                  val       ///< value returned
+                    )
+{
+  writeValue( pymodule, attr, std::is_floating_point< T >::value ? 'f' : 'i', sizeof( T ), &val );
+}
+
+#endif
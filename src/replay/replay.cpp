@@ -0,0 +1,233 @@
+// Replays a trace recorded with EmbeddedInterpreter::recordStart without the
+// original simulation, rebuilding embedded modules from the recorded data so
+// python modules can be benchmarked and tuned offline
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pybind11/pybind11.h"
+#include "pybind11/embed.h"
+#include "pybind11/numpy.h"
+
+#include "EmbeddedInterpreter.hpp"
+#include "Trace.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Values recorded for a single embedded attribute, served back in order
+////////////////////////////////////////////////////////////////////////////////
+struct ReplayValues
+{
+  std::string                        pymodule; ///< Python module the value was embedded in
+  std::string                        attr;     ///< python attribute of the value
+  char                               kind;     ///< numpy type kind of the value
+  size_t                             itemSize; ///< size of the value
+  std::vector< std::vector< char > > values;   ///< each value returned, in order
+  size_t                             next;     ///< index of the next value to serve
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Recorded raw value as a python object
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static pybind11::object
+asObject( const std::vector< char > &bytes )
+{
+  T val;
+  std::memcpy( &val, bytes.data(), sizeof( T ) );
+  return pybind11::cast( val );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Embed a replay-owned buffer with the recorded layout
+////////////////////////////////////////////////////////////////////////////////
+template< typename T >
+static void
+embedBuffer( EmbeddedInterpreter &interp, const TraceRecord &record, std::vector< uint64_t > &buffer )
+{
+  std::vector< size_t > dims( record.dims );
+  T *ptr = reinterpret_cast< T * >( buffer.data() );
+  if ( record.fortranOrder )
+  {
+    interp.embedPtr< pybind11::array::f_style >( record.pymodule, record.attr, ptr, dims.size(), dims.data() );
+  }
+  else
+  {
+    interp.embedPtr< pybind11::array::c_style >( record.pymodule, record.attr, ptr, dims.size(), dims.data() );
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Command line help
+////////////////////////////////////////////////////////////////////////////////
+static void
+usage( const char *exe )
+{
+  std::cout << "Usage: " << exe << " trace [-n repeat] [-p path]..."                            << std::endl
+            << "  trace      : file written by EmbeddedInterpreter_recordStart"                 << std::endl
+            << "  -n repeat  : number of times to replay the recorded calls, default 1"         << std::endl
+            << "  -p path    : additional python module search path, may be given repeatedly" << std::endl;
+}
+
+int
+main( int argc, char **argv )
+{
+  std::string                traceFile;
+  size_t                     repeat = 1;
+  std::vector< std::string > paths;
+
+  for ( int i = 1; i < argc; i++ )
+  {
+    std::string arg( argv[i] );
+    if      ( arg == "-n" && i + 1 < argc ) repeat = std::strtoul( argv[++i], 0, 10 );
+    else if ( arg == "-p" && i + 1 < argc ) paths.push_back( argv[++i] );
+    else if ( arg == "-h" || arg == "--help" || !traceFile.empty() )
+    {
+      usage( argv[0] );
+      return arg == "-h" || arg == "--help" ? 0 : 1;
+    }
+    else traceFile = arg;
+  }
+  if ( traceFile.empty() )
+  {
+    usage( argv[0] );
+    return 1;
+  }
+
+  // Outlive the interpreter, python holds pointers into these
+  std::map< std::string, ReplayValues >            values;
+  std::map< std::string, std::vector< uint64_t > > buffers;
+
+  EmbeddedInterpreter interp;
+  interp.initialize();
+  for ( size_t i = 0; i < paths.size(); i++ )
+  {
+    interp.addToScope( paths[i] );
+  }
+
+  TraceReader reader;
+  TraceRecord record;
+  reader.open( traceFile );
+
+  // First pass collects values so they are available before any module uses them
+  while ( reader.next( record, true ) )
+  {
+    if ( record.type == TraceRecord::VALUE )
+    {
+      ReplayValues &recorded = values[ record.pymodule + "." + record.attr ];
+      recorded.pymodule = record.pymodule;
+      recorded.attr     = record.attr;
+      recorded.kind     = record.kind;
+      recorded.itemSize = record.itemSize;
+      recorded.next     = 0;
+      recorded.values.push_back( record.bytes );
+    }
+  }
+
+  for ( size_t pass = 0; pass < repeat; pass++ )
+  {
+    size_t calls = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    reader.rewind();
+    for ( std::map< std::string, ReplayValues >::iterator it = values.begin(); it != values.end(); ++it )
+    {
+      it->second.next = 0;
+    }
+
+    while ( reader.next( record ) )
+    {
+      switch ( record.type )
+      {
+        case TraceRecord::SCOPE :
+        {
+          if ( pass == 0 ) interp.addToScope( record.attr );
+          break;
+        }
+        case TraceRecord::EMBEDDED_LOAD :
+        {
+          if ( pass > 0 ) break;
+
+          interp.embeddedPymoduleLoad( record.pymodule );
+
+          // Serve recorded values in order, repeating the last once exhausted
+          pybind11::module_ mod = pybind11::module_::import( record.pymodule.c_str() );
+          for ( std::map< std::string, ReplayValues >::iterator it = values.begin(); it != values.end(); ++it )
+          {
+            if ( it->second.pymodule != record.pymodule ) continue;
+
+            ReplayValues *pValues = &it->second;
+            mod.def(
+                    pValues->attr.c_str(),
+                    [pValues]()
+                    {
+                      const std::vector< char > &bytes = pValues->values[ pValues->next ];
+                      if ( pValues->next + 1 < pValues->values.size() ) pValues->next++;
+
+                      if ( pValues->kind == 'f' && pValues->itemSize == sizeof( double ) ) return asObject< double  >( bytes );
+                      if ( pValues->kind == 'f' && pValues->itemSize == sizeof( float  ) ) return asObject< float   >( bytes );
+                      return asObject< int32_t >( bytes );
+                    }
+                    );
+          }
+          break;
+        }
+        case TraceRecord::ARRAY :
+        {
+          EmbeddedArray layout;
+          layout.itemSize = record.itemSize;
+          layout.dims     = record.dims;
+
+          std::vector< uint64_t > &buffer = buffers[ record.pymodule + "." + record.attr ];
+          size_t                   words  = ( layout.numBytes() + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t );
+          if ( pass > 0 && buffer.size() == words ) break;
+
+          buffer.assign( words, 0 );
+          if      ( record.kind == 'f' && record.itemSize == sizeof( double  ) ) embedBuffer< double  >( interp, record, buffer );
+          else if ( record.kind == 'f' && record.itemSize == sizeof( float   ) ) embedBuffer< float   >( interp, record, buffer );
+          else if ( record.kind == 'i' && record.itemSize == sizeof( int32_t ) ) embedBuffer< int32_t >( interp, record, buffer );
+          else
+          {
+            std::cerr << "Warning: Unsupported array type of '" << record.pymodule << "." << record.attr << "', not replayed" << std::endl;
+          }
+          break;
+        }
+        case TraceRecord::DATA :
+        {
+          std::vector< uint64_t > &buffer = buffers[ record.pymodule + "." + record.attr ];
+          if ( buffer.size() * sizeof( uint64_t ) < record.bytes.size() )
+          {
+            std::cerr << "Warning: Data of '" << record.pymodule << "." << record.attr << "' does not fit its layout, not replayed" << std::endl;
+            break;
+          }
+          std::memcpy( buffer.data(), record.bytes.data(), record.bytes.size() );
+          interp.markDirty( record.pymodule, record.attr );
+          break;
+        }
+        case TraceRecord::MODULE_LOAD :
+        {
+          if ( pass == 0 ) interp.pymoduleLoad( record.pymodule );
+          break;
+        }
+        case TraceRecord::CALL :
+        {
+          interp.pymoduleCall( record.pymodule, record.attr );
+          calls++;
+          break;
+        }
+        default :
+          break;
+      }
+    }
+
+    double elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+    std::cout << "Replay pass " << pass << " : " << calls << " calls in " << elapsed << " s" << std::endl;
+  }
+
+  // Reports per call timing
+  interp.finalize();
+  return 0;
+}
@@ -0,0 +1,171 @@
+// Native reduced precision conversion, stats, and histograms of embedded arrays
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <fenv.h>
+
+#include "ArrayKernels.hpp"
+#include "EmbeddedArray.hpp"
+#include "TestCheck.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Reduced copy of values as type
+////////////////////////////////////////////////////////////////////////////////
+template< typename Q >
+static std::vector< Q >
+reduced( std::vector< double > &values, int type, double &offset, double &scale )
+{
+  size_t           dims[1] = { values.size() };
+  EmbeddedArray    array   = makeEmbeddedArray( values.data(), 1, dims, true );
+  std::vector< Q > out( values.size() );
+  ArrayKernels::reduce( array, type, out.data(), offset, scale );
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Quantization of finite, NaN, and inf values including a zero scale
+////////////////////////////////////////////////////////////////////////////////
+static void
+testQuantize()
+{
+  const double inf = std::numeric_limits< double >::infinity();
+  const double nan = std::numeric_limits< double >::quiet_NaN();
+  double       offset, scale;
+
+  std::vector< double >  values( 8 );
+  values[0] = 0.0; values[1] = 1.0; values[2] = 2.0; values[3] = 4.0;
+  values[4] = nan; values[5] = inf; values[6] = -inf; values[7] = 3.0;
+
+  std::vector< uint8_t > q8 = reduced< uint8_t >( values, ArrayKernels::UINT8, offset, scale );
+  TEST_CHECK( offset == 0.0 && scale == 4.0 / 255 );
+  TEST_CHECK( q8[0] == 0 && q8[3] == 255 );
+  TEST_CHECK( std::fabs( offset + q8[1] * scale - 1.0 ) <= scale );
+  TEST_CHECK( std::fabs( offset + q8[7] * scale - 3.0 ) <= scale );
+  TEST_CHECK( q8[4] == 0 && q8[5] == 255 && q8[6] == 0 );
+
+  // Constant finite values give a zero scale, +inf must still saturate high
+  std::vector< double > constant( 4, 5.0 );
+  constant[1] = inf; constant[2] = -inf; constant[3] = nan;
+  std::vector< uint16_t > q16 = reduced< uint16_t >( constant, ArrayKernels::UINT16, offset, scale );
+  TEST_CHECK( offset == 5.0 && scale == 0.0 );
+  TEST_CHECK( q16[0] == 0 && q16[1] == 65535 && q16[2] == 0 && q16[3] == 0 );
+
+  // No finite values at all
+  std::vector< double > nonFinite( 3, nan );
+  nonFinite[1] = inf;
+  q16 = reduced< uint16_t >( nonFinite, ArrayKernels::UINT16, offset, scale );
+  TEST_CHECK( q16[0] == 0 && q16[1] == 65535 && q16[2] == 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Half precision bit patterns at the edges of each case
+////////////////////////////////////////////////////////////////////////////////
+static void
+testFloat16()
+{
+  TEST_CHECK( ArrayKernels::floatToHalf( 0.0f )        == 0x0000 );
+  TEST_CHECK( ArrayKernels::floatToHalf( -0.0f )       == 0x8000 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 1.0f )        == 0x3c00 );
+  TEST_CHECK( ArrayKernels::floatToHalf( -2.0f )       == 0xc000 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 65504.0f )    == 0x7bff );
+  TEST_CHECK( ArrayKernels::floatToHalf( 65520.0f )    == 0x7c00 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 1.0e10f )     == 0x7c00 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 6.1035156e-5f ) == 0x0400 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 5.9604645e-8f ) == 0x0001 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 2.9802322e-8f ) == 0x0000 );
+  TEST_CHECK( ArrayKernels::floatToHalf( std::numeric_limits< float >::infinity() )  == 0x7c00 );
+  TEST_CHECK( ArrayKernels::floatToHalf( -std::numeric_limits< float >::infinity() ) == 0xfc00 );
+  TEST_CHECK( ArrayKernels::floatToHalf( std::numeric_limits< float >::quiet_NaN() ) == 0x7e00 );
+
+  // 1 + 2^-11 is halfway between halves and rounds to even
+  TEST_CHECK( ArrayKernels::floatToHalf( 1.00048828125f ) == 0x3c00 );
+  TEST_CHECK( ArrayKernels::floatToHalf( 1.00146484375f ) == 0x3c02 );
+
+  const double          nan = std::numeric_limits< double >::quiet_NaN();
+  std::vector< double > values( 3, 1.0 );
+  values[1] = nan;
+  double offset, scale;
+  std::vector< uint16_t > h = reduced< uint16_t >( values, ArrayKernels::FLOAT16, offset, scale );
+  TEST_CHECK( h[0] == 0x3c00 && h[1] == 0x7e00 && offset == 0.0 && scale == 1.0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Stats and histograms with NaN and inf spread across every thread's share
+////////////////////////////////////////////////////////////////////////////////
+static void
+testStatsHistogram()
+{
+  const double inf = std::numeric_limits< double >::infinity();
+  const double nan = std::numeric_limits< double >::quiet_NaN();
+
+  std::vector< double > values( 10000 );
+  size_t                numNaN = 0, numInf = 0, count = 0;
+  double                sum    = 0.0;
+  for ( size_t i = 0; i < values.size(); i++ )
+  {
+    if      ( i % 7  == 3 ) { values[i] = nan;                         numNaN++; }
+    else if ( i % 11 == 5 ) { values[i] = i % 2 ? inf : -inf;          numInf++; }
+    else                    { values[i] = static_cast< double >( i % 100 ); sum += values[i]; count++; }
+  }
+  double mean = sum / count;
+  double sqr  = 0.0;
+  for ( size_t i = 0; i < values.size(); i++ )
+  {
+    if ( std::isfinite( values[i] ) ) sqr += ( values[i] - mean ) * ( values[i] - mean );
+  }
+
+  size_t              dims[1] = { values.size() };
+  EmbeddedArray       array   = makeEmbeddedArray( values.data(), 1, dims, true );
+  ArrayKernels::Stats stats;
+  ArrayKernels::stats( array, stats );
+
+  TEST_CHECK( stats.count == count && stats.numNaN == numNaN && stats.numInf == numInf );
+  TEST_CHECK( stats.min == 0.0 && stats.max == 99.0 );
+  TEST_CHECK( std::fabs( stats.sum - sum ) <= 1e-9 * sum );
+  TEST_CHECK( std::fabs( stats.mean - mean ) <= 1e-12 * mean );
+  TEST_CHECK( std::fabs( stats.variance - sqr / count ) <= 1e-9 * sqr / count );
+
+  // Last bin is closed, NaN is reported rather than binned
+  std::vector< int64_t > counts( 4 );
+  size_t                 binnedNaN = ArrayKernels::histogram( array, 0.0, 99.0, counts );
+  int64_t                binned    = counts[0] + counts[1] + counts[2] + counts[3];
+  TEST_CHECK( binnedNaN == numNaN );
+  TEST_CHECK( binned == static_cast< int64_t >( count ) );
+
+  // Narrower range drops out of range values
+  ArrayKernels::histogram( array, 10.0, 19.0, counts );
+  size_t inRange = 0;
+  for ( size_t i = 0; i < values.size(); i++ )
+  {
+    if ( std::isfinite( values[i] ) && values[i] >= 10.0 && values[i] <= 19.0 ) inRange++;
+  }
+  TEST_CHECK( counts[0] + counts[1] + counts[2] + counts[3] == static_cast< int64_t >( inRange ) );
+
+  // Nothing finite at all
+  std::vector< double > nonFinite( 64, nan );
+  nonFinite[3] = inf;
+  size_t nonFiniteDims[1] = { nonFinite.size() };
+  EmbeddedArray empty = makeEmbeddedArray( nonFinite.data(), 1, nonFiniteDims, true );
+  ArrayKernels::stats( empty, stats );
+  TEST_CHECK( stats.count == 0 && stats.numNaN == 63 && stats.numInf == 1 );
+  TEST_CHECK( std::isnan( stats.min ) && std::isnan( stats.mean ) && std::isnan( stats.variance ) );
+  TEST_CHECK( ArrayKernels::histogram( empty, 0.0, 1.0, counts ) == 63 );
+  TEST_CHECK( counts[0] + counts[1] + counts[2] + counts[3] == 0 );
+}
+
+int
+main()
+{
+  feclearexcept( FE_ALL_EXCEPT );
+
+  testQuantize();
+  testFloat16();
+  testStatsHistogram();
+
+  // NaN must never reach an ordered comparison
+  TEST_CHECK( !fetestexcept( FE_INVALID ) );
+
+  return testFailures();
+}
@@ -0,0 +1,87 @@
+// Native .npy and container output of embedded arrays
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "ArrayWriter.hpp"
+#include "EmbeddedArray.hpp"
+#include "TestCheck.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Contents of a whole file
+////////////////////////////////////////////////////////////////////////////////
+static std::string
+readFile( const std::string &filename )
+{
+  std::ifstream in( filename.c_str(), std::ios::in | std::ios::binary );
+  return std::string( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+}
+
+int
+main()
+{
+  std::vector< double > data( 12 );
+  for ( size_t i = 0; i < data.size(); i++ ) data[i] = 0.5 * i;
+  size_t        dims[2] = { 3, 4 };
+  EmbeddedArray array   = makeEmbeddedArray( data.data(), 2, dims, true );
+
+  // Header is aligned and describes the layout
+  std::string header = ArrayWriter::npyHeader( array );
+  TEST_CHECK( header.size() % 64 == 0 );
+  TEST_CHECK( header.compare( 0, 6, "\x93NUMPY" ) == 0 );
+  TEST_CHECK( header.find( "'fortran_order': True" ) != std::string::npos );
+  TEST_CHECK( header.find( "'shape': (3, 4)" )      != std::string::npos );
+  TEST_CHECK( header[ header.size() - 1 ] == '\n' );
+
+  ArrayWriter writer;
+
+  // Synchronous write is header followed by raw data
+  writer.writeNpy( array, "ArrayWriterTest_sync.npy", ArrayWriter::SYNC );
+  std::string contents = readFile( "ArrayWriterTest_sync.npy" );
+  TEST_CHECK( contents.size() == header.size() + array.numBytes() );
+  TEST_CHECK( std::memcmp( contents.data() + header.size(), data.data(), array.numBytes() ) == 0 );
+
+  // Snapshot writes data as it was at submission
+  writer.writeNpy( array, "ArrayWriterTest_snapshot.npy", ArrayWriter::ASYNC_SNAPSHOT );
+  data[0] = -1.0;
+  writer.wait();
+  contents = readFile( "ArrayWriterTest_snapshot.npy" );
+  TEST_CHECK( contents.size() == header.size() + array.numBytes() );
+  double first = -1.0;
+  if ( contents.size() >= header.size() + sizeof( double ) ) std::memcpy( &first, contents.data() + header.size(), sizeof( double ) );
+  TEST_CHECK( first == 0.0 );
+
+  // Container places each array at its indexed offset
+  ArrayWriter::NamedArrays named;
+  named.push_back( std::make_pair( std::string( "a" ), array ) );
+  named.push_back( std::make_pair( std::string( "b" ), array ) );
+  writer.writeContainer( named, "ArrayWriterTest.container", ArrayWriter::ASYNC );
+  writer.wait();
+  std::string container = readFile( "ArrayWriterTest.container" );
+  std::string index     = readFile( "ArrayWriterTest.container.index" );
+  size_t      offsetB   = ( ( header.size() + array.numBytes() + 63 ) / 64 ) * 64 + header.size();
+  TEST_CHECK( index.find( "a " + std::to_string( header.size() ) + " <f8 F 3,4" ) != std::string::npos );
+  TEST_CHECK( index.find( "b " + std::to_string( offsetB )       + " <f8 F 3,4" ) != std::string::npos );
+  TEST_CHECK( container.size() >= offsetB + array.numBytes() );
+  TEST_CHECK( container.size() >= offsetB + array.numBytes() && std::memcmp( container.data() + offsetB, data.data(), array.numBytes() ) == 0 );
+
+  // Unknown modes are rejected rather than treated as asynchronous
+  TEST_CHECK_THROWS( writer.writeNpy( array, "ArrayWriterTest_bad.npy", 7 ) );
+  TEST_CHECK_THROWS( writer.writeNpy( array, "ArrayWriterTest_bad.npy", -1 ) );
+
+  // Errors on the writer thread surface from the next wait(), once
+  writer.writeNpy( array, "no/such/directory/ArrayWriterTest.npy", ArrayWriter::ASYNC );
+  TEST_CHECK_THROWS( writer.wait() );
+  writer.wait();
+
+  // An index that cannot be written fails the container as well
+  mkdir( "ArrayWriterTest_blocked.container.index", 0755 );
+  TEST_CHECK_THROWS( writer.writeContainer( named, "ArrayWriterTest_blocked.container", ArrayWriter::SYNC ) );
+
+  writer.stop();
+  return testFailures();
+}
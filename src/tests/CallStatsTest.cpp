@@ -0,0 +1,111 @@
+// Timing and memory accounting of pymoduleCall, including failed and overlapping calls
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "EmbeddedInterpreter.hpp"
+#include "PythonCheck.hpp"
+#include "TestCheck.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Columns of the finalize report row for key, empty if not reported
+////////////////////////////////////////////////////////////////////////////////
+static std::vector< std::string >
+reportRow( const std::string &report, const std::string &key )
+{
+  std::istringstream lines( report );
+  std::string        line;
+  while ( std::getline( lines, line ) )
+  {
+    std::istringstream         fields( line );
+    std::vector< std::string > row;
+    std::string                field;
+    while ( fields >> field ) row.push_back( field );
+    if ( !row.empty() && row[0] == key ) return row;
+  }
+  return std::vector< std::string >();
+}
+
+int
+main()
+{
+  EmbeddedInterpreter interp;
+  interp.initialize();
+  interp.embeddedPymoduleLoad( "test_calls" );
+
+  TEST_CHECK_PYTHON(
+                    "import test_calls, threading, time\n"
+                    "exec( '''\n"
+                    "import threading, time\n"
+                    "barrier = threading.Barrier( 2 )\n"
+                    "def grow() :\n"
+                    "  global keep\n"
+                    "  keep = bytearray( 1 << 20 )\n"
+                    "def fail() :\n"
+                    "  raise ValueError( 'expected' )\n"
+                    "def overlap() :\n"
+                    "  barrier.wait()\n"
+                    "def idle() :\n"
+                    "  time.sleep( 0.2 )\n"
+                    "''', test_calls.__dict__ )\n"
+                    );
+
+  interp.pymoduleLoad( "test_calls" );
+  interp.memoryTracking( true );
+
+  interp.pymoduleCall( "test_calls", "grow" );
+  interp.pymoduleCall( "test_calls", "grow" );
+  TEST_CHECK_THROWS( interp.pymoduleCall( "test_calls", "fail" ) );
+  TEST_CHECK_THROWS( interp.pymoduleCall( "test_calls", "fail" ) );
+
+  // Both calls are inside python at once, neither may claim the shared peak
+  {
+    pybind11::gil_scoped_release release;
+    std::vector< std::thread >   threads;
+    for ( int i = 0; i < 2; i++ )
+    {
+      threads.push_back( std::thread( [&interp]()
+                                      {
+                                        pybind11::gil_scoped_acquire acquire;
+                                        interp.pymoduleCall( "test_calls", "overlap" );
+                                      } ) );
+    }
+    for ( size_t i = 0; i < threads.size(); i++ ) threads[i].join();
+  }
+
+  // Exclusive calls are accounted again
+  interp.pymoduleCall( "test_calls", "grow" );
+
+  // Tracing is only on while tracked calls run
+  TEST_CHECK_PYTHON( "import tracemalloc\nassert not tracemalloc.is_tracing()\n" );
+
+  // Stacks sampled during a call do not count towards its peak
+  interp.profilerStart( 2000.0, "" );
+  interp.pymoduleCall( "test_calls", "idle" );
+  interp.profilerStop();
+
+  // Columns stay in the report for calls tracked before tracking was turned off
+  interp.memoryTracking( false );
+
+  std::stringstream report;
+  std::streambuf   *stdoutBuf = std::cout.rdbuf( report.rdbuf() );
+  interp.finalize();
+  std::cout.rdbuf( stdoutBuf );
+
+  // key calls failed total mean max accounted peak retained overBudget
+  std::vector< std::string > grow    = reportRow( report.str(), "test_calls:grow" );
+  std::vector< std::string > fail    = reportRow( report.str(), "test_calls:fail" );
+  std::vector< std::string > overlap = reportRow( report.str(), "test_calls:overlap" );
+  std::vector< std::string > idle    = reportRow( report.str(), "test_calls:idle" );
+
+  TEST_CHECK( grow.size()    == 10 && grow[1]    == "3" && grow[2]    == "0" && grow[6]    == "3" );
+  TEST_CHECK( grow.size()    == 10 && std::stod( grow[7] ) >= 1.0 );
+  TEST_CHECK( fail.size()    == 10 && fail[1]    == "2" && fail[2]    == "2" && fail[6]    == "0" );
+  TEST_CHECK( overlap.size() == 10 && overlap[1] == "2" && overlap[2] == "0" && overlap[6] == "0" );
+  TEST_CHECK( idle.size()    == 10 && idle[6]    == "1" && std::stod( idle[7] ) < 0.002 );
+
+  if ( testFailures() ) std::cerr << report.str();
+  return testFailures();
+}
@@ -0,0 +1,89 @@
+// Dirty tracking, memoization, and reductions of embedded arrays as seen from python
+#include <vector>
+
+#include "EmbeddedInterpreter.hpp"
+#include "PythonCheck.hpp"
+#include "TestCheck.hpp"
+
+int
+main()
+{
+  std::vector< double > data( 10, 1.0 );
+  size_t                dims[1] = { data.size() };
+
+  EmbeddedInterpreter interp;
+  interp.initialize();
+  interp.embeddedPymoduleLoad( "test_data" );
+  interp.embedPtr< pybind11::array::f_style >( "test_data", "arr", data.data(), 1, dims );
+
+  TEST_CHECK_PYTHON(
+                    "import test_data\n"
+                    "assert test_data.version( 'arr' ) == 0\n"
+                    "calls = []\n"
+                    "def total( a ) :\n"
+                    "  calls.append( 1 )\n"
+                    "  return float( a.sum() )\n"
+                    "assert test_data.memoize( 'arr', total ) == 10.0\n"
+                    "assert test_data.memoize( 'arr', total ) == 10.0\n"
+                    "assert len( calls ) == 1\n"
+                    // Distinct callables never share a result, even with the same name
+                    "assert test_data.memoize( 'arr', lambda a : 1 ) == 1\n"
+                    "assert test_data.memoize( 'arr', lambda a : 2 ) == 2\n"
+                    "assert test_data.memoize( 'arr', lambda a : 3, key='k' ) == 3\n"
+                    "assert test_data.memoize( 'arr', lambda a : 4, key='k' ) == 3\n"
+                    );
+
+  data[3] = 2.0;
+  data[4] = 2.0;
+  interp.markDirtyRange( "test_data", "arr", 3, 5 );
+
+  TEST_CHECK( interp.arrayVersion( "test_data", "arr" ) == 1 );
+  TEST_CHECK_PYTHON(
+                    "import test_data\n"
+                    "assert test_data.version( 'arr' ) == 1\n"
+                    "assert tuple( test_data.dirty( 'arr' ) ) == ( 1, 3, 5 )\n"
+                    "assert test_data.memoize( 'arr', lambda a : float( a.sum() ), key='sum' ) == 12.0\n"
+                    "test_data.clean( 'arr' )\n"
+                    "assert tuple( test_data.dirty( 'arr' ) ) == ( 1, 0, 0 )\n"
+                    );
+
+  // Unversioned arrays are reconverted on every call, versioned ones only once marked
+  std::vector< double > plain( 4, 1.0 );
+  size_t                plainDims[1] = { plain.size() };
+  interp.embedPtr< pybind11::array::f_style >( "test_data", "plain", plain.data(), 1, plainDims );
+  TEST_CHECK_PYTHON( "import test_data\nassert float( test_data.reduced( 'plain' ).sum() ) == 4.0\n" );
+  plain[0] = 5.0;
+  TEST_CHECK_PYTHON(
+                    "import test_data\n"
+                    "first = test_data.reduced( 'plain' )\n"
+                    "assert float( first.sum() ) == 8.0\n"
+                    "test_data.plain()[1] = 3.0\n"
+                    "assert float( test_data.reduced( 'plain' ).sum() ) == 10.0\n"
+                    "assert float( first.sum() ) == 8.0\n"
+                    "q, offset, scale = test_data.reduced( 'plain', 'uint8' )\n"
+                    "assert abs( offset + q.max() * scale - 5.0 ) < 0.05\n"
+                    );
+
+  // Histograms report the NaN values they drop and take any ( lo, hi ) sequence
+  TEST_CHECK_PYTHON(
+                    "import test_data\n"
+                    "test_data.plain()[3] = float( 'nan' )\n"
+                    "counts, edges, nan = test_data.histogram( 'plain', bins=2, range=[ 0.0, 6.0 ] )\n"
+                    "assert nan == 1 and list( counts ) == [ 2, 2 ]\n"
+                    "assert list( edges ) == [ 0.0, 3.0, 6.0 ]\n"
+                    "counts, edges, nan = test_data.histogram( 'plain', bins=2, range=( 0.0, 6.0 ) )\n"
+                    "assert nan == 1 and list( counts ) == [ 2, 2 ]\n"
+                    );
+
+  // Fortran bindings take 1-based inclusive ranges
+  char pymodule[] = "test_data";
+  char attr[]     = "arr";
+  EmbeddedInterpreter_markDirtyRange( &interp, pymodule, attr, 1, 2 );
+  TEST_CHECK( interp.arrayVersion( "test_data", "arr" ) == 2 );
+  TEST_CHECK_THROWS( EmbeddedInterpreter_markDirtyRange( &interp, pymodule, attr, 0, 2 ) );
+  TEST_CHECK_THROWS( EmbeddedInterpreter_markDirtyRange( &interp, pymodule, attr, 5, 4 ) );
+  TEST_CHECK( interp.arrayVersion( "test_data", "arr" ) == 2 );
+
+  interp.finalize();
+  return testFailures();
+}
@@ -0,0 +1,40 @@
+// Version counting and dirty regions of embedded arrays
+#include <vector>
+
+#include "EmbeddedArray.hpp"
+#include "TestCheck.hpp"
+
+int
+main()
+{
+  std::vector< float > data( 24 );
+  size_t               dims[3] = { 2, 3, 4 };
+  EmbeddedArray        array   = makeEmbeddedArray( data.data(), 3, dims, true );
+
+  TEST_CHECK( array.kind == 'f' && array.itemSize == sizeof( float ) );
+  TEST_CHECK( array.numElements() == 24 && array.numBytes() == 24 * sizeof( float ) );
+  TEST_CHECK( array.version == 0 && array.dirtyBegin == array.dirtyEnd );
+
+  // Ranges grow to their union, each mark bumps the version
+  array.markDirty( 4, 6 );
+  TEST_CHECK( array.version == 1 && array.dirtyBegin == 4 && array.dirtyEnd == 6 );
+  array.markDirty( 10, 12 );
+  TEST_CHECK( array.version == 2 && array.dirtyBegin == 4 && array.dirtyEnd == 12 );
+  array.markDirty( 1, 2 );
+  TEST_CHECK( array.version == 3 && array.dirtyBegin == 1 && array.dirtyEnd == 12 );
+
+  // Clamped to the array, empty ranges change nothing
+  array.markDirty( 20, 100 );
+  TEST_CHECK( array.version == 4 && array.dirtyEnd == 24 );
+  array.markDirty( 5, 5 );
+  array.markDirty( 30, 40 );
+  TEST_CHECK( array.version == 4 );
+
+  // A cleaned array starts a fresh region
+  array.dirtyBegin = 0;
+  array.dirtyEnd   = 0;
+  array.markDirty( 7, 8 );
+  TEST_CHECK( array.version == 5 && array.dirtyBegin == 7 && array.dirtyEnd == 8 );
+
+  return testFailures();
+}
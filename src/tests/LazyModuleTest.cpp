@@ -0,0 +1,89 @@
+// Embedded modules created at runtime with attributes defined on first access
+#include <vector>
+
+#include "EmbeddedInterpreter.hpp"
+#include "PythonCheck.hpp"
+#include "TestCheck.hpp"
+
+static int numCalls = 0;
+
+static int
+countedValue()
+{
+  return ++numCalls;
+}
+
+int
+main()
+{
+  std::vector< double > data( 4, 2.0 );
+  size_t                dims[1] = { data.size() };
+
+  EmbeddedInterpreter interp;
+  interp.initialize();
+  interp.embeddedPymoduleLoad( "test_lazy" );
+  interp.embeddedPymoduleLoad( "test_pkg.fields" );
+  interp.embeddedPymoduleLoad( "test_empty" );
+
+  interp.embedPtr< pybind11::array::f_style >( "test_lazy", "arr", data.data(), 1, dims );
+  interp.embedValue( "test_lazy", "answer", 42 );
+  interp.embedValueFunc( "test_pkg.fields", "counted", countedValue );
+
+  // Helpers are defined eagerly, user attributes may not hide behind them
+  TEST_CHECK_THROWS( interp.embedValue( "test_lazy", "stats", 1 ) );
+  TEST_CHECK_THROWS( interp.embedValue( "test_lazy", "__getattr__", 1 ) );
+
+  // Only the helpers a module is given are reserved, nor may helpers hide user attributes
+  interp.embedValueFunc( "test_lazy", "emit", countedValue );
+  interp.embedValue( "test_pkg.fields", "version", 3 );
+  interp.embedValue( "test_pkg.fields", "emit", 4 );
+  TEST_CHECK_THROWS( interp.embedPtr< pybind11::array::f_style >( "test_pkg.fields", "arr", data.data(), 1, dims ) );
+  TEST_CHECK_THROWS( interp.channelCreate< double >( "test_pkg.fields", "events", 2, 8 ) );
+  TEST_CHECK_THROWS( interp.channelCreate< double >( "test_lazy", "events", 2, 8 ) );
+
+  // Modules python imported on its own are not taken over
+  TEST_CHECK_PYTHON( "import sys, types\nsys.modules['test_foreign'] = types.ModuleType( 'test_foreign' )\n" );
+  TEST_CHECK_THROWS( interp.embeddedPymoduleLoad( "test_foreign" ) );
+  TEST_CHECK_PYTHON( "import test_foreign\nassert not hasattr( test_foreign, '__pyio_embedded__' )\n" );
+
+  // Pending attributes are listed but only defined once touched
+  TEST_CHECK_PYTHON(
+                    "import test_lazy\n"
+                    "assert 'arr' in dir( test_lazy ) and 'arr' not in test_lazy.__dict__\n"
+                    "assert 'answer' in dir( test_lazy ) and 'answer' not in test_lazy.__dict__\n"
+                    "assert test_lazy.answer() == 42\n"
+                    "assert 'answer' in test_lazy.__dict__\n"
+                    "assert float( test_lazy.arr().sum() ) == 8.0\n"
+                    "assert not hasattr( test_lazy, 'missing' )\n"
+                    "try :\n"
+                    "  test_lazy.missing\n"
+                    "  assert False\n"
+                    "except AttributeError :\n"
+                    "  pass\n"
+                    );
+
+  // Modules without any embedded attributes raise AttributeError as well
+  TEST_CHECK_PYTHON(
+                    "import test_empty\n"
+                    "assert not hasattr( test_empty, 'anything' )\n"
+                    "assert 'anything' not in dir( test_empty )\n"
+                    );
+
+  // Dotted names create their parent package, the function is not called until read
+  TEST_CHECK( numCalls == 0 );
+  TEST_CHECK_PYTHON(
+                    "import test_pkg.fields\n"
+                    "from test_pkg import fields\n"
+                    "assert fields is test_pkg.fields\n"
+                    "assert fields.counted() == 1\n"
+                    "assert fields.version() == 3 and fields.emit() == 4\n"
+                    );
+  TEST_CHECK( numCalls == 1 );
+
+  // Re-registering an attribute python already used redefines it right away
+  interp.embedValue( "test_lazy", "answer", 7 );
+  TEST_CHECK_PYTHON( "import test_lazy\nassert test_lazy.answer() == 7\n" );
+
+  interp.finalize();
+  return testFailures();
+}
@@ -0,0 +1,129 @@
+// Per-thread record rings of output channels, drained natively
+#include <cstdint>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "OutputChannel.hpp"
+#include "TestCheck.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Records come back whole and in emission order, wrapping around the
+///        end of the ring, with those that do not fit dropped and counted
+////////////////////////////////////////////////////////////////////////////////
+static void
+testSingleProducer()
+{
+  TEST_CHECK_THROWS( OutputChannel( 'i', sizeof( int32_t ), 0, 4 ) );
+  TEST_CHECK_THROWS( OutputChannel( 'i', sizeof( int32_t ), 2, 0 ) );
+
+  OutputChannel channel( 'i', sizeof( int32_t ), 2, 4 );
+  TEST_CHECK( channel.kind() == 'i' && channel.itemSize() == sizeof( int32_t ) && channel.recordLength() == 2 );
+
+  int32_t                records[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+  std::vector< int32_t > out( 8 );
+
+  TEST_CHECK( channel.emit( records, 3 ) == 3 );
+  TEST_CHECK( channel.pending() == 3 );
+  TEST_CHECK( channel.drain( out.data(), 2 ) == 2 );
+  TEST_CHECK( out[0] == 0 && out[1] == 1 && out[2] == 2 && out[3] == 3 );
+  TEST_CHECK( channel.pending() == 1 );
+
+  // Third record sits at the end of the ring, the next wraps to its start
+  TEST_CHECK( channel.emit( records + 6, 2 ) == 2 );
+  TEST_CHECK( channel.drain( out.data(), 4 ) == 3 );
+  for ( int32_t i = 0; i < 6; i++ )
+  {
+    TEST_CHECK( out[i] == i + 4 );
+  }
+  TEST_CHECK( channel.pending() == 0 && channel.dropped() == 0 );
+
+  // Only capacity records are held, the rest are dropped
+  TEST_CHECK( channel.emit( records, 5 ) == 4 );
+  TEST_CHECK( channel.emit( records, 1 ) == 0 );
+  TEST_CHECK( channel.pending() == 4 && channel.dropped() == 2 );
+  TEST_CHECK( channel.drain( out.data(), 4 ) == 4 );
+  TEST_CHECK( out[0] == 0 && out[7] == 7 );
+  TEST_CHECK( channel.drain( out.data(), 4 ) == 0 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Each thread appends to its own ring, nothing is lost across threads,
+///        threads beyond those the channel was made for are rejected
+////////////////////////////////////////////////////////////////////////////////
+static void
+testThreads()
+{
+#ifdef _OPENMP
+  const int numThreads = 4;
+  omp_set_num_threads( numThreads );
+#else
+  const int numThreads = 1;
+#endif
+  const int perThread = 100;
+
+  OutputChannel channel( 'f', sizeof( double ), 2, perThread );
+
+  std::vector< size_t > accepted( numThreads, 0 );
+#ifdef _OPENMP
+#pragma omp parallel for schedule( static, 1 )
+#endif
+  for ( int t = 0; t < numThreads; t++ )
+  {
+    for ( int i = 0; i < perThread; i++ )
+    {
+      double record[2] = { static_cast< double >( t ), static_cast< double >( i ) };
+      accepted[t] += channel.emit( record, 1 );
+    }
+  }
+  for ( int t = 0; t < numThreads; t++ )
+  {
+    TEST_CHECK( accepted[t] == perThread );
+  }
+  TEST_CHECK( channel.pending() == static_cast< size_t >( numThreads * perThread ) && channel.dropped() == 0 );
+
+  // Per-thread order is kept within each ring
+  std::vector< double > out( 2 * numThreads * perThread );
+  TEST_CHECK( channel.drain( out.data(), numThreads * perThread ) == static_cast< size_t >( numThreads * perThread ) );
+  std::vector< int > next( numThreads, 0 );
+  for ( size_t r = 0; r < out.size() / 2; r++ )
+  {
+    int t = static_cast< int >( out[ 2 * r ] );
+    TEST_CHECK( t >= 0 && t < numThreads );
+    if ( t < 0 || t >= numThreads ) continue;
+    TEST_CHECK( out[ 2 * r + 1 ] == next[t] );
+    next[t]++;
+  }
+
+#ifdef _OPENMP
+  std::vector< int > threw( numThreads + 2, 0 );
+#pragma omp parallel num_threads( numThreads + 2 )
+  {
+    int    t         = omp_get_thread_num();
+    double record[2] = { 0.0, 0.0 };
+    try
+    {
+      channel.emit( record, 1 );
+    }
+    catch ( const std::exception & )
+    {
+      threw[t] = 1;
+    }
+  }
+  for ( int t = 0; t < numThreads + 2; t++ )
+  {
+    TEST_CHECK( threw[t] == ( t >= numThreads ? 1 : 0 ) );
+  }
+#endif
+}
+
+int
+main()
+{
+  testSingleProducer();
+  testThreads();
+
+  return testFailures();
+}
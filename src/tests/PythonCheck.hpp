@@ -0,0 +1,31 @@
+#ifndef PythonCheck_hpp
+#define PythonCheck_hpp
+
+#include <iostream>
+
+#include "pybind11/pybind11.h"
+#include "pybind11/embed.h"
+
+#include "TestCheck.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Run python source in a fresh namespace, any exception including a
+///        failed assert is reported and counted as a failure
+////////////////////////////////////////////////////////////////////////////////
+#define TEST_CHECK_PYTHON( CODE )                                                      \
+  do                                                                                   \
+  {                                                                                    \
+    try                                                                                \
+    {                                                                                  \
+      pybind11::dict scope;                                                            \
+      scope[ "__builtins__" ] = pybind11::module_::import( "builtins" );               \
+      pybind11::exec( CODE, scope );                                                   \
+    }                                                                                  \
+    catch ( const std::exception &e )                                                  \
+    {                                                                                  \
+      std::cerr << __FILE__ << ":" << __LINE__ << " : Check failed: " << e.what() << std::endl; \
+      testFailures()++;                                                                \
+    }                                                                                  \
+  } while ( 0 )
+
+#endif
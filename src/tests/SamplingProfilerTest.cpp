@@ -0,0 +1,53 @@
+// Sampling of python stacks attributed to the call in flight
+#include <fstream>
+#include <string>
+
+#include "SamplingProfiler.hpp"
+#include "PythonCheck.hpp"
+#include "TestCheck.hpp"
+
+int
+main()
+{
+  pybind11::scoped_interpreter guard;
+  SamplingProfiler             profiler;
+
+  profiler.start( 500.0 );
+
+  // Not within a call, never sampled
+  TEST_CHECK_PYTHON(
+                    "import time\n"
+                    "def idle() :\n"
+                    "  start = time.time()\n"
+                    "  while time.time() - start < 0.1 : pass\n"
+                    "idle()\n"
+                    );
+
+  profiler.callEnter( "test:spin" );
+  TEST_CHECK_PYTHON(
+                    "import time\n"
+                    "def spin() :\n"
+                    "  start = time.time()\n"
+                    "  while time.time() - start < 0.3 : pass\n"
+                    "spin()\n"
+                    );
+  profiler.callExit();
+  profiler.stop();
+
+  TEST_CHECK( profiler.write( "SamplingProfilerTest.folded" ) );
+
+  std::ifstream in( "SamplingProfilerTest.folded" );
+  std::string   line;
+  size_t        spinSamples  = 0;
+  size_t        otherSamples = 0;
+  while ( std::getline( in, line ) )
+  {
+    size_t count = std::stoul( line.substr( line.rfind( ' ' ) + 1 ) );
+    if ( line.compare( 0, 10, "test:spin;" ) == 0 && line.find( ";spin (" ) != std::string::npos ) spinSamples += count;
+    else otherSamples += count;
+  }
+  TEST_CHECK( spinSamples > 0 );
+  TEST_CHECK( otherSamples == 0 );
+
+  return testFailures();
+}
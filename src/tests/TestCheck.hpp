@@ -0,0 +1,40 @@
+#ifndef TestCheck_hpp
+#define TestCheck_hpp
+
+#include <iostream>
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Minimal checks for the ctest executables, each failure is reported
+///        and counted, main returns testFailures() so ctest sees the result
+////////////////////////////////////////////////////////////////////////////////
+inline int &
+testFailures()
+{
+  static int failures = 0;
+  return failures;
+}
+
+#define TEST_CHECK( COND )                                                                    \
+  do                                                                                          \
+  {                                                                                           \
+    if ( !( COND ) )                                                                          \
+    {                                                                                         \
+      std::cerr << __FILE__ << ":" << __LINE__ << " : Check failed: " << #COND << std::endl; \
+      testFailures()++;                                                                       \
+    }                                                                                         \
+  } while ( 0 )
+
+#define TEST_CHECK_THROWS( EXPR )                                                                    \
+  do                                                                                                 \
+  {                                                                                                  \
+    bool thrown = false;                                                                             \
+    try { EXPR; } catch ( const std::exception & ) { thrown = true; }                                \
+    if ( !thrown )                                                                                   \
+    {                                                                                                \
+      std::cerr << __FILE__ << ":" << __LINE__ << " : Check failed: " << #EXPR << " did not throw" << std::endl; \
+      testFailures()++;                                                                              \
+    }                                                                                                \
+  } while ( 0 )
+
+#endif
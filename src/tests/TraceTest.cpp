@@ -0,0 +1,104 @@
+// Round trip of record-and-replay traces
+#include <string>
+#include <vector>
+
+#include "EmbeddedArray.hpp"
+#include "TestCheck.hpp"
+#include "Trace.hpp"
+
+int
+main()
+{
+  std::vector< double > data( 16, 1.0 );
+  std::vector< int >    flags( 4, 0 );
+  size_t                dataDims[2] = { 4, 4 };
+  size_t                flagDims[1] = { 4 };
+  EmbeddedArray         dataArray   = makeEmbeddedArray( data.data(),  2, dataDims, true );
+  EmbeddedArray         flagArray   = makeEmbeddedArray( flags.data(), 1, flagDims, false );
+
+  TraceWriter writer;
+  writer.open( "TraceTest.bin" );
+  writer.scope( "/some/path" );
+  writer.embeddedLoad( "test_data" );
+  writer.array( "test_data", "data",  dataArray );
+  writer.array( "test_data", "flags", flagArray );
+  writer.moduleLoad( "test_user" );
+
+  // Unmarked arrays are hashed, only changed contents are written
+  writer.data( "test_data", "data",  dataArray );
+  writer.data( "test_data", "flags", flagArray );
+  writer.call( "test_user", "step" );
+  writer.data( "test_data", "data",  dataArray );
+  writer.data( "test_data", "flags", flagArray );
+  writer.call( "test_user", "step" );
+  data[15] = 2.0;
+  writer.data( "test_data", "data",  dataArray );
+  writer.data( "test_data", "flags", flagArray );
+  writer.value( "test_data", "dt", 0.25 );
+  writer.call( "test_user", "step" );
+
+  // Marking is recorded once
+  flags[0] = 7;
+  flagArray.markDirty( 0, 1 );
+  writer.data( "test_data", "flags", flagArray );
+  writer.data( "test_data", "flags", flagArray );
+  writer.call( "test_user", "step" );
+
+  // Writes after the last mark are recorded as well
+  flags[1] = 9;
+  writer.data( "test_data", "flags", flagArray );
+  writer.data( "test_data", "flags", flagArray );
+  writer.call( "test_user", "step" );
+  writer.close();
+
+  const char expected[] = "SEAALDDCCDVCDCDC";
+
+  TraceReader reader;
+  TraceRecord record;
+  std::string types;
+  std::vector< TraceRecord > records;
+  reader.open( "TraceTest.bin" );
+  while ( reader.next( record ) )
+  {
+    types.push_back( record.type );
+    records.push_back( record );
+  }
+  TEST_CHECK( types == expected );
+
+  if ( types == expected )
+  {
+    TEST_CHECK( records[0].attr == "/some/path" );
+    TEST_CHECK( records[1].pymodule == "test_data" );
+    TEST_CHECK( records[2].attr == "data" && records[2].kind == 'f' && records[2].itemSize == sizeof( double ) );
+    TEST_CHECK( records[2].fortranOrder && records[2].dims == std::vector< size_t >( dataDims, dataDims + 2 ) );
+    TEST_CHECK( records[3].attr == "flags" && records[3].kind == 'i' && !records[3].fortranOrder );
+    TEST_CHECK( records[4].pymodule == "test_user" );
+
+    TEST_CHECK( records[5].attr == "data"  && records[5].bytes.size() == dataArray.numBytes() );
+    TEST_CHECK( records[6].attr == "flags" && records[6].bytes.size() == flagArray.numBytes() );
+    TEST_CHECK( records[7].pymodule == "test_user" && records[7].attr == "step" );
+
+    const double *changed = reinterpret_cast< const double * >( records[9].bytes.data() );
+    TEST_CHECK( records[9].attr == "data" && changed[15] == 2.0 && changed[0] == 1.0 );
+
+    double dt = 0.0;
+    if ( records[10].bytes.size() == sizeof( dt ) ) dt = *reinterpret_cast< const double * >( records[10].bytes.data() );
+    TEST_CHECK( records[10].attr == "dt" && records[10].kind == 'f' && dt == 0.25 );
+
+    TEST_CHECK( records[12].attr == "flags" && reinterpret_cast< const int * >( records[12].bytes.data() )[0] == 7 );
+    TEST_CHECK( records[14].attr == "flags" && reinterpret_cast< const int * >( records[14].bytes.data() )[1] == 9 );
+  }
+
+  // Rewind replays the same records, contents may be skipped
+  reader.rewind();
+  size_t numRecords = 0;
+  bool   skipped    = true;
+  while ( reader.next( record, true ) )
+  {
+    numRecords++;
+    if ( record.type == TraceRecord::DATA ) skipped = skipped && record.bytes.empty();
+  }
+  TEST_CHECK( numRecords == types.size() && skipped );
+
+  return testFailures();
+}
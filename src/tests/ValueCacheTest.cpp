@@ -0,0 +1,83 @@
+// Caching policies of values embedded with embedValueFunc / embedValueCase
+#include <cstring>
+
+#include "EmbeddedInterpreter.hpp"
+#include "PythonCheck.hpp"
+#include "TestCheck.hpp"
+
+static int numFuncCalls = 0;
+static int numCaseCalls = 0;
+
+static double
+funcValue()
+{
+  return ++numFuncCalls;
+}
+
+static int
+caseValue( const char *attrCase )
+{
+  numCaseCalls++;
+  return std::strcmp( attrCase, "steps" ) == 0 ? 100 + numCaseCalls : -1;
+}
+
+int
+main()
+{
+  EmbeddedInterpreter interp;
+  interp.initialize();
+  interp.embeddedPymoduleLoad( "test_values" );
+  interp.embedValueFunc( "test_values", "always", funcValue );
+  interp.embedValueFunc( "test_values", "once",   funcValue );
+  interp.embedValueCase( "test_values", "epoch",  "steps", caseValue );
+  interp.valueCache( "test_values", "once",  EmbeddedInterpreter::CACHE_ONCE  );
+  interp.valueCache( "test_values", "epoch", EmbeddedInterpreter::CACHE_EPOCH );
+
+  TEST_CHECK_THROWS( interp.valueCache( "test_values", "missing", EmbeddedInterpreter::CACHE_ONCE ) );
+  TEST_CHECK_THROWS( interp.valueCache( "test_values", "once", 7 ) );
+
+  // Every read of an uncached value calls back
+  TEST_CHECK_PYTHON(
+                    "import test_values\n"
+                    "assert test_values.always() == 1.0\n"
+                    "assert test_values.always() == 2.0\n"
+                    );
+  TEST_CHECK( numFuncCalls == 2 );
+
+  // Once cached values are only evaluated on the first read
+  TEST_CHECK_PYTHON(
+                    "import test_values\n"
+                    "assert test_values.once() == 3.0\n"
+                    "assert test_values.once() == 3.0\n"
+                    );
+  interp.advanceEpoch();
+  TEST_CHECK_PYTHON( "import test_values\nassert test_values.once() == 3.0\n" );
+  TEST_CHECK( numFuncCalls == 3 );
+
+  // Epoch values are evaluated once per epoch, with their case passed through
+  TEST_CHECK_PYTHON(
+                    "import test_values\n"
+                    "assert test_values.epoch() == 101\n"
+                    "assert test_values.epoch() == 101\n"
+                    );
+  TEST_CHECK( numCaseCalls == 1 );
+  interp.advanceEpoch();
+  TEST_CHECK_PYTHON(
+                    "import test_values\n"
+                    "assert test_values.epoch() == 102\n"
+                    "assert test_values.epoch() == 102\n"
+                    );
+  TEST_CHECK( numCaseCalls == 2 );
+
+  // Changing the policy discards the cached value
+  interp.valueCache( "test_values", "once", EmbeddedInterpreter::CACHE_ONCE );
+  TEST_CHECK_PYTHON( "import test_values\nassert test_values.once() == 4.0\n" );
+
+  // Fortran binding advances the epoch as well
+  EmbeddedInterpreter_advanceEpoch( &interp );
+  TEST_CHECK_PYTHON( "import test_values\nassert test_values.epoch() == 103\n" );
+  TEST_CHECK( numCaseCalls == 3 && numFuncCalls == 4 );
+
+  interp.finalize();
+  return testFailures();
+}